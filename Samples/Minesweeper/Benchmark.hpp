@@ -0,0 +1,228 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Game.hpp"
+# include "Solver.hpp"
+
+/// @brief ベンチマークで次に開くマスを選ぶ方法
+enum class BenchmarkPolicy : uint8
+{
+	Solver,		// ソルバーのヒント（安全なマス、なければ 💣 である確率が最も低いマス）を開く
+	RandomSafe,	// 💣 ではないマスをランダムな順に開く（必ずクリアできる）
+};
+
+/// @brief ベンチマークの設定
+struct BenchmarkConfig
+{
+	/// @brief 盤面のマス目の数
+	Size size{ 30, 16 };
+
+	/// @brief 💣 の個数
+	int32 mineCount = 99;
+
+	/// @brief プレイする盤面の数
+	int32 boardCount = 1000;
+
+	/// @brief 最初の盤面のシード（i 番目の盤面は seed + i）
+	uint64 seed = 0;
+
+	/// @brief 盤面の生成方法
+	GeneratorMode generatorMode = GeneratorMode::Classic;
+
+	/// @brief 次に開くマスを選ぶ方法
+	BenchmarkPolicy policy = BenchmarkPolicy::RandomSafe;
+};
+
+/// @brief ベンチマークの結果
+/// @remark 時間は、盤面の生成とマスを開く操作（クリア判定を含む）の時間の合計です。次に開くマスを選ぶ時間は含みません。
+struct BenchmarkResult
+{
+	/// @brief プレイした盤面の数
+	int32 boardCount = 0;
+
+	/// @brief クリアした盤面の数
+	int32 clearedCount = 0;
+
+	/// @brief NoGuess モードで、推測なしで解ける盤面が見つからなかった盤面の数
+	int32 mayNeedGuessCount = 0;
+
+	/// @brief クリックの回数
+	int64 clickCount = 0;
+
+	/// @brief ゲームの処理にかかった時間（秒）
+	double seconds = 0.0;
+
+	/// @brief 次に開くマスを選ぶのにかかった時間（秒）
+	double policySeconds = 0.0;
+
+	/// @brief 1 回のクリックにかかった時間の中央値（マイクロ秒）
+	double p50 = 0.0;
+
+	/// @brief 1 回のクリックにかかった時間の 99 パーセンタイル（マイクロ秒）
+	double p99 = 0.0;
+
+	/// @brief 1 秒あたりにプレイできる盤面の数
+	[[nodiscard]]
+	double boardsPerSec() const noexcept
+	{
+		return (boardCount / seconds);
+	}
+
+	/// @brief 1 秒あたりのクリックの回数
+	[[nodiscard]]
+	double clicksPerSec() const noexcept
+	{
+		return (clickCount / seconds);
+	}
+};
+
+/// @brief 盤面を左上から順に調べて、最初の開かれていないマスを返します。
+/// @param board 盤面
+/// @return 最初の開かれていないマス。すべて開かれている場合は none
+[[nodiscard]]
+inline Optional<Point> FindFirstUnopenedCell(const Board& board)
+{
+	for (int32 y = 0; y < board.height(); ++y)
+	{
+		for (int32 x = 0; x < board.width(); ++x)
+		{
+			if (not board[Point{ x, y }].isOpened())
+			{
+				return Point{ x, y };
+			}
+		}
+	}
+
+	return none;
+}
+
+/// @brief 固定のシードから生成した盤面を、ウィンドウなしで自動でプレイして、ゲームの処理の速さを計測します。
+/// @param config ベンチマークの設定
+/// @return ベンチマークの結果
+inline BenchmarkResult RunBenchmark(const BenchmarkConfig& config)
+{
+	BenchmarkResult result{ .boardCount = config.boardCount };
+
+	// 1 回のクリックにかかった時間（ナノ秒）
+	Array<uint64> latencies;
+
+	uint64 gameNanosec = 0;
+	uint64 policyNanosec = 0;
+
+	Array<Point> openQueue;
+	Array<Point> safeCells;
+	Solver solver;
+	DefaultRNG rng;
+
+	for (int32 i = 0; i < config.boardCount; ++i)
+	{
+		const uint64 seed = (config.seed + i);
+
+		uint64 start = Time::GetNanosec();
+		Board board = ((config.generatorMode == GeneratorMode::Classic) ? MakeGame(config.size, config.mineCount, seed) : Board{ config.size });
+		gameNanosec += (Time::GetNanosec() - start);
+
+		GameState gameState = GameState::Game;
+		int32 unopenedCount = config.size.area();
+		bool mayNeedGuess = false;
+
+		if (config.policy == BenchmarkPolicy::Solver)
+		{
+			solver = Solver{ config.size };
+		}
+		else
+		{
+			// 💣 ではないマスをランダムな順に並べる（NoGuess モードでは盤面が最初のクリックで決まるので、最初のクリックは中央）
+			safeCells.clear();
+			rng.seed(seed);
+		}
+
+		size_t nextSafeCell = 0;
+
+		while (gameState == GameState::Game)
+		{
+			// 次に開くマスを選ぶ
+			start = Time::GetNanosec();
+
+			Point pos{ (config.size.x / 2), (config.size.y / 2) };
+
+			if (config.policy == BenchmarkPolicy::Solver)
+			{
+				if (unopenedCount != config.size.area()) // 最初のクリックは中央
+				{
+					if (const auto hint = solver.findHint(board, config.mineCount))
+					{
+						pos = hint->pos;
+					}
+					else if (const auto unopened = FindFirstUnopenedCell(board))
+					{
+						// ヒントが無い場合は、最初の開かれていないマスを開く
+						pos = *unopened;
+					}
+					else
+					{
+						// 開くマスが無い
+						break;
+					}
+				}
+			}
+			else if ((config.generatorMode == GeneratorMode::Classic) || (unopenedCount != config.size.area()))
+			{
+				if (safeCells.isEmpty())
+				{
+					for (int32 y = 0; y < board.height(); ++y)
+					{
+						for (int32 x = 0; x < board.width(); ++x)
+						{
+							if (not board[Point{ x, y }].isMine())
+							{
+								safeCells << Point{ x, y };
+							}
+						}
+					}
+
+					Shuffle(safeCells, rng);
+				}
+
+				while (board[safeCells[nextSafeCell]].isOpened())
+				{
+					++nextSafeCell;
+				}
+
+				pos = safeCells[nextSafeCell];
+			}
+
+			policyNanosec += (Time::GetNanosec() - start);
+
+			// そのマスを開く
+			start = Time::GetNanosec();
+			ApplyAction(gameState, board, config.generatorMode, config.mineCount, seed, unopenedCount, mayNeedGuess, openQueue, pos, Action::Open);
+			const uint64 latency = (Time::GetNanosec() - start);
+
+			gameNanosec += latency;
+			latencies << latency;
+		}
+
+		if (gameState == GameState::Cleared)
+		{
+			++result.clearedCount;
+		}
+
+		if (mayNeedGuess)
+		{
+			++result.mayNeedGuessCount;
+		}
+	}
+
+	result.clickCount = static_cast<int64>(latencies.size());
+	result.seconds = (gameNanosec / 1e9);
+	result.policySeconds = (policyNanosec / 1e9);
+
+	if (not latencies.isEmpty())
+	{
+		latencies.sort();
+		result.p50 = (latencies[(latencies.size() - 1) * 50 / 100] / 1e3);
+		result.p99 = (latencies[(latencies.size() - 1) * 99 / 100] / 1e3);
+	}
+
+	return result;
+}
@@ -0,0 +1,908 @@
+# pragma once
+# include <Siv3D.hpp>
+# include <bit>
+# include <cstring>
+
+/// @brief 1 マスの状態を 1 バイトに詰めたもの
+/// @remark 下位 4 ビットが周囲の 💣 の個数、上位 4 ビットが開かれている・旗・爆発・💣 のフラグです。
+struct PackedCell
+{
+	/// @brief 周囲の 💣 の個数 (0～8) を格納するビット
+	static constexpr uint8 CountMask = 0b0000'1111;
+
+	/// @brief 開かれているかを表すビット
+	static constexpr uint8 OpenedBit = 0b0001'0000;
+
+	/// @brief 旗が立てられているかを表すビット
+	static constexpr uint8 FlaggedBit = 0b0010'0000;
+
+	/// @brief 爆発したかを表すビット
+	static constexpr uint8 ExplodedBit = 0b0100'0000;
+
+	/// @brief 💣 であるかを表すビット
+	static constexpr uint8 MineBit = 0b1000'0000;
+
+	uint8 bits = 0;
+
+	/// @brief 周囲の 💣 の個数を返します。
+	/// @return 周囲の 💣 の個数
+	[[nodiscard]]
+	constexpr int32 adjacentMines() const noexcept
+	{
+		return (bits & CountMask);
+	}
+
+	/// @brief 💣 であれば -1, それ以外の場合は周囲の 💣 の個数を返します。
+	/// @return マスの数字
+	[[nodiscard]]
+	constexpr int32 number() const noexcept
+	{
+		return (isMine() ? -1 : adjacentMines());
+	}
+
+	/// @brief 開かれているかを返します。
+	[[nodiscard]]
+	constexpr bool isOpened() const noexcept
+	{
+		return ((bits & OpenedBit) != 0);
+	}
+
+	/// @brief 旗が立てられているかを返します。
+	[[nodiscard]]
+	constexpr bool isFlagged() const noexcept
+	{
+		return ((bits & FlaggedBit) != 0);
+	}
+
+	/// @brief 爆発したかを返します。
+	[[nodiscard]]
+	constexpr bool isExploded() const noexcept
+	{
+		return ((bits & ExplodedBit) != 0);
+	}
+
+	/// @brief 💣 であるかを返します。
+	[[nodiscard]]
+	constexpr bool isMine() const noexcept
+	{
+		return ((bits & MineBit) != 0);
+	}
+};
+
+static_assert(sizeof(PackedCell) == 1);
+
+/// @brief 周囲のマスへのオフセット
+constexpr Point Offsets[8] =
+{
+	{ -1, -1 }, { 0, -1 }, { 1, -1 },
+	{ -1,  0 }           , { 1,  0 },
+	{ -1,  1 }, { 0,  1 }, { 1,  1 },
+};
+
+/// @brief 盤面の各マスに 1 ビットずつ割り当てた二次元のビット配列
+/// @remark 各行は 64 マス単位に切り上げて格納します。行末の余りのビットは常に 0 です。
+class BitPlane
+{
+public:
+
+	BitPlane() = default;
+
+	/// @brief すべてのビットが 0 のビット配列を作成します。
+	/// @param size 盤面のマス目の数
+	explicit BitPlane(const Size& size)
+		: m_size{ size }
+		, m_wordsPerRow{ ((size.x + 63) / 64) }
+		, m_words(static_cast<size_t>(m_wordsPerRow) * size.y) {}
+
+	/// @brief 指定したマスのビットを返します。
+	[[nodiscard]]
+	bool get(const Point& pos) const noexcept
+	{
+		return ((m_words[wordIndex(pos)] >> (pos.x % 64)) & 1);
+	}
+
+	/// @brief 指定したマスのビットを 1 にします。
+	void set(const Point& pos) noexcept
+	{
+		m_words[wordIndex(pos)] |= (1ULL << (pos.x % 64));
+	}
+
+	/// @brief 指定したマスのビットを 0 にします。
+	void reset(const Point& pos) noexcept
+	{
+		m_words[wordIndex(pos)] &= ~(1ULL << (pos.x % 64));
+	}
+
+	/// @brief 1 のビットの個数を返します。
+	/// @return 1 のビットの個数
+	[[nodiscard]]
+	int32 count() const noexcept
+	{
+		int32 result = 0;
+
+		for (const uint64 word : m_words)
+		{
+			result += std::popcount(word);
+		}
+
+		return result;
+	}
+
+	[[nodiscard]]
+	const Size& size() const noexcept
+	{
+		return m_size;
+	}
+
+	/// @brief 1 行あたりの 64 ビットワードの個数を返します。
+	[[nodiscard]]
+	int32 wordsPerRow() const noexcept
+	{
+		return m_wordsPerRow;
+	}
+
+	/// @brief 指定した行の先頭のワードへのポインタを返します。
+	[[nodiscard]]
+	uint64* row(int32 y) noexcept
+	{
+		return (m_words.data() + static_cast<size_t>(m_wordsPerRow) * y);
+	}
+
+	/// @brief 指定した行の先頭のワードへのポインタを返します。
+	[[nodiscard]]
+	const uint64* row(int32 y) const noexcept
+	{
+		return (m_words.data() + static_cast<size_t>(m_wordsPerRow) * y);
+	}
+
+private:
+
+	Size m_size{ 0, 0 };
+
+	int32 m_wordsPerRow = 0;
+
+	Array<uint64> m_words;
+
+	[[nodiscard]]
+	size_t wordIndex(const Point& pos) const noexcept
+	{
+		return (static_cast<size_t>(m_wordsPerRow) * pos.y + (pos.x / 64));
+	}
+};
+
+/// @brief 8 ビットを、ビット k が k バイト目の 0 / 1 になる 8 バイトに展開する表
+/// @remark 展開した値をそのままメモリに書き込むので、リトルエンディアンを前提とします。
+inline constexpr std::array<uint64, 256> MineBytesTable = []()
+{
+	static_assert(std::endian::native == std::endian::little);
+
+	std::array<uint64, 256> table{};
+
+	for (uint32 bits = 0; bits < 256; ++bits)
+	{
+		for (uint32 k = 0; k < 8; ++k)
+		{
+			table[bits] |= (static_cast<uint64>((bits >> k) & 1) << (k * 8));
+		}
+	}
+
+	return table;
+}();
+
+/// @brief マインスイーパーの盤面
+/// @remark 各マスの状態は 1 バイトの PackedCell で持ちます。💣 と開かれたマスは BitPlane にも並行して持ち、64 マス単位でまとめて処理できるようにしています。
+/// 状態を変えたマスの行を記録するので、描画では盤面全体を比べずに、変わった行だけを調べられます。
+class Board
+{
+public:
+
+	Board() = default;
+
+	/// @brief 💣 の無い、すべてのマスが開かれていない盤面を作成します。
+	/// @param size 盤面のマス目の数
+	explicit Board(const Size& size)
+		: m_cells(size)
+		, m_mines{ size }
+		, m_opened{ size }
+		, m_rowDirty(size.y, 0)
+	{
+		markAllRowsDirty();
+	}
+
+	[[nodiscard]]
+	Size size() const noexcept
+	{
+		return m_cells.size();
+	}
+
+	[[nodiscard]]
+	int32 width() const noexcept
+	{
+		return static_cast<int32>(m_cells.width());
+	}
+
+	[[nodiscard]]
+	int32 height() const noexcept
+	{
+		return static_cast<int32>(m_cells.height());
+	}
+
+	[[nodiscard]]
+	bool inBounds(const Point& pos) const noexcept
+	{
+		return m_cells.inBounds(pos);
+	}
+
+	[[nodiscard]]
+	PackedCell operator [](const Point& pos) const
+	{
+		return m_cells[pos];
+	}
+
+	/// @brief y 行目のマスの状態の先頭へのポインタを返します。
+	[[nodiscard]]
+	const PackedCell* row(int32 y) const
+	{
+		return m_cells[y];
+	}
+
+	/// @brief 💣 であれば -1, それ以外の場合は周囲の 💣 の個数を返します。
+	[[nodiscard]]
+	int32 number(const Point& pos) const
+	{
+		return m_cells[pos].number();
+	}
+
+	/// @brief 💣 を設置します。
+	void setMine(const Point& pos)
+	{
+		m_cells[pos].bits |= PackedCell::MineBit;
+		m_mines.set(pos);
+		markRowDirty(pos.y);
+	}
+
+	/// @brief すべてのマスについて、周囲の 💣 の個数を計算します。
+	/// @remark 💣 のビットプレーンを 1 マス 1 バイトに展開した行を上下 3 行分持ち、左右にずらして足し合わせます。
+	/// 展開した行は左右に 1 マスずつ余白を持つので、範囲チェックは不要です。大きな盤面では行を帯状に分けて並列に計算します。
+	void updateAdjacentMines()
+	{
+		const int32 h = height();
+
+		markAllRowsDirty();
+
+	# if SIV3D_PLATFORM(WEB)
+
+		updateAdjacentMines(0, h);
+
+	# else
+
+		const int32 bandCount = ((ParallelThreshold <= m_cells.num_elements())
+			? Min(h, static_cast<int32>(Threading::GetConcurrency())) : 1);
+
+		if (bandCount <= 1)
+		{
+			updateAdjacentMines(0, h);
+			return;
+		}
+
+		Array<AsyncTask<void>> tasks;
+
+		for (int32 i = 0; i < bandCount; ++i)
+		{
+			const int32 beginY = (h * i / bandCount);
+			const int32 endY = (h * (i + 1) / bandCount);
+			tasks << Async([this, beginY, endY]() { updateAdjacentMines(beginY, endY); });
+		}
+
+		for (auto& task : tasks)
+		{
+			task.get();
+		}
+
+	# endif
+	}
+
+	/// @brief マスを開きます。
+	/// @return 新たに開いた場合 true, すでに開かれていた場合は false
+	bool open(const Point& pos)
+	{
+		auto& cell = m_cells[pos];
+
+		if (cell.isOpened())
+		{
+			return false;
+		}
+
+		cell.bits |= PackedCell::OpenedBit;
+		m_opened.set(pos);
+		markRowDirty(pos.y);
+		return true;
+	}
+
+	/// @brief 旗の状態を反転します。
+	void toggleFlag(const Point& pos)
+	{
+		m_cells[pos].bits ^= PackedCell::FlaggedBit;
+		markRowDirty(pos.y);
+	}
+
+	/// @brief 爆発したフラグを立てます。
+	void explode(const Point& pos)
+	{
+		m_cells[pos].bits |= PackedCell::ExplodedBit;
+		markRowDirty(pos.y);
+	}
+
+	/// @brief すべての 💣 マスを開きます。
+	/// @return 新たに開いたマスの個数
+	int32 openAllMines()
+	{
+		int32 openedCount = 0;
+
+		for (int32 y = 0; y < height(); ++y)
+		{
+			const uint64* mines = m_mines.row(y);
+			uint64* opened = m_opened.row(y);
+
+			for (int32 i = 0; i < m_opened.wordsPerRow(); ++i)
+			{
+				// 64 マスのうち、まだ開かれていない 💣 マス
+				uint64 newlyOpened = (mines[i] & ~opened[i]);
+
+				if (newlyOpened == 0)
+				{
+					continue;
+				}
+
+				opened[i] |= newlyOpened;
+				openedCount += std::popcount(newlyOpened);
+				markRowDirty(y);
+
+				// 1 バイトの状態にも反映する
+				for (; newlyOpened; newlyOpened &= (newlyOpened - 1))
+				{
+					m_cells[y][i * 64 + std::countr_zero(newlyOpened)].bits |= PackedCell::OpenedBit;
+				}
+			}
+		}
+
+		return openedCount;
+	}
+
+	/// @brief 開かれていないマスの個数を数えます。
+	/// @return 開かれていないマスの個数
+	[[nodiscard]]
+	int32 countUnopened() const noexcept
+	{
+		return (static_cast<int32>(m_cells.num_elements()) - m_opened.count());
+	}
+
+	/// @brief 💣 の配置を返します。
+	[[nodiscard]]
+	const BitPlane& mines() const noexcept
+	{
+		return m_mines;
+	}
+
+	/// @brief 開かれたマスの配置を返します。
+	[[nodiscard]]
+	const BitPlane& opened() const noexcept
+	{
+		return m_opened;
+	}
+
+	/// @brief 前回 clearDirtyRows() を呼んでから、状態が変わったマスを含む行を返します。
+	/// @remark 盤面を作成した直後は、すべての行を含みます。同じ行は 1 回だけ含みます。
+	[[nodiscard]]
+	const Array<int32>& dirtyRows() const noexcept
+	{
+		return m_dirtyRows;
+	}
+
+	/// @brief 状態が変わった行の記録を消去します。
+	void clearDirtyRows()
+	{
+		for (const int32 y : m_dirtyRows)
+		{
+			m_rowDirty[y] = 0;
+		}
+
+		m_dirtyRows.clear();
+	}
+
+private:
+
+	// 周囲の 💣 の個数の計算を並列化するマス目の数の下限
+	static constexpr size_t ParallelThreshold = (1 << 20);
+
+	// 各マスの状態
+	Grid<PackedCell> m_cells;
+
+	// 💣 の配置
+	BitPlane m_mines;
+
+	// 開かれたマスの配置
+	BitPlane m_opened;
+
+	// 各行が m_dirtyRows に含まれているか
+	Array<uint8> m_rowDirty;
+
+	// 前回 clearDirtyRows() を呼んでから、状態が変わったマスを含む行
+	Array<int32> m_dirtyRows;
+
+	void markRowDirty(int32 y)
+	{
+		if (not m_rowDirty[y])
+		{
+			m_rowDirty[y] = 1;
+			m_dirtyRows << y;
+		}
+	}
+
+	void markAllRowsDirty()
+	{
+		for (int32 y = 0; y < height(); ++y)
+		{
+			markRowDirty(y);
+		}
+	}
+
+	// y 行目の 💣 のビットを 1 マス 1 バイトに展開する。dst の両端の余白と、盤面外の行は 0 にする
+	void unpackMineRow(int32 y, uint8* dst) const
+	{
+		const int32 w = width();
+
+		dst[0] = dst[w + 1] = 0;
+
+		if ((y < 0) || (height() <= y))
+		{
+			std::fill_n(dst + 1, w, uint8{ 0 });
+			return;
+		}
+
+		const uint64* words = m_mines.row(y);
+		const int32 fullWords = (w / 64);
+
+		// 64 マスずつ、8 ビットを 8 バイトに展開する表で 8 マスずつ書き込む
+		for (int32 i = 0; i < fullWords; ++i)
+		{
+			const uint64 word = words[i];
+			uint8* out = (dst + 1 + i * 64);
+
+			for (int32 k = 0; k < 8; ++k)
+			{
+				const uint64 bytes = MineBytesTable[(word >> (k * 8)) & 0xFF];
+				std::memcpy((out + k * 8), &bytes, sizeof(bytes));
+			}
+		}
+
+		// 残りのマス（8 マス単位で展開し、盤面内の分だけ書き込む）
+		for (int32 x = (fullWords * 64); x < w; x += 8)
+		{
+			const uint64 bytes = MineBytesTable[(words[x / 64] >> (x % 64)) & 0xFF];
+			std::memcpy((dst + 1 + x), &bytes, static_cast<size_t>(Min((w - x), 8)));
+		}
+	}
+
+	// [beginY, endY) 行のマスについて、周囲の 💣 の個数を計算する
+	// 💣 のビットプレーンを読み、1 バイトの状態の下位 4 ビットだけを書き換えるので、他の行を担当するスレッドと干渉しない
+	void updateAdjacentMines(int32 beginY, int32 endY)
+	{
+		const int32 w = width();
+		const size_t stride = (static_cast<size_t>(w) + 2);
+
+		// 上・中・下の 3 行分の作業用の行
+		Array<uint8> buffer(stride * 3);
+		uint8* above = buffer.data();
+		uint8* center = (above + stride);
+		uint8* below = (center + stride);
+
+		unpackMineRow((beginY - 1), above);
+		unpackMineRow(beginY, center);
+
+		for (int32 y = beginY; y < endY; ++y)
+		{
+			unpackMineRow((y + 1), below);
+
+			PackedCell* cells = m_cells[y];
+
+			for (int32 x = 0; x < w; ++x)
+			{
+				// 展開した行では x + 1 が自身の列
+				const uint8 count = static_cast<uint8>(above[x] + above[x + 1] + above[x + 2]
+					+ center[x] + center[x + 2]
+					+ below[x] + below[x + 1] + below[x + 2]);
+
+				cells[x].bits = static_cast<uint8>((cells[x].bits & ~PackedCell::CountMask) | count);
+			}
+
+			// 1 行下にずらす
+			std::swap(above, center);
+			std::swap(center, below);
+		}
+	}
+};
+
+/// @brief 盤面に指定した個数の 💣 をランダムに設置します。
+/// @param board 盤面（💣 が設置されていないこと）
+/// @param bombs 設置する 💣 の個数（💣 を設置できるマスの数以下であること）
+/// @param seed 乱数のシード。同じシードからは同じ配置が得られます
+/// @param safeCenter 指定した場合、そのマスと周囲 8 マスには 💣 を設置しません
+/// @remark すでに 💣 のあるマスを引き直すことがないので、💣 の密度によらず線形時間で終わります。
+/// 💣 が少ない場合は、マスのインデックスの列を先頭 bombs 個だけシャッフル (Fisher-Yates) して選びます。入れ替えたインデックスだけをハッシュテーブルに記録するので O(bombs) です。
+/// 💣 が多い場合は、先頭のマスから順に「残りの 💣 の個数 / 残りのマスの個数」の確率で選びます (Selection sampling)。O(マス目の数) ですが、マス目の数は 💣 の個数の 8 倍以下です。
+inline void PlaceMines(Board& board, int32 bombs, uint64 seed, const Optional<Point>& safeCenter = none)
+{
+	const int32 width = board.width();
+
+	// 💣 を設置しないマスのインデックス（昇順）
+	Array<int32> excluded;
+
+	if (safeCenter)
+	{
+		for (int32 y = (safeCenter->y - 1); y <= (safeCenter->y + 1); ++y)
+		{
+			for (int32 x = (safeCenter->x - 1); x <= (safeCenter->x + 1); ++x)
+			{
+				if (board.inBounds(Point{ x, y }))
+				{
+					excluded << (y * width + x);
+				}
+			}
+		}
+	}
+
+	// 💣 を設置できるマスの数
+	const int32 cellCount = (width * board.height() - static_cast<int32>(excluded.size()));
+
+	assert(bombs <= cellCount);
+
+	// 💣 を設置できるマスのうち i 番目のマスを返す
+	const auto toPoint = [&excluded, width](int32 i)
+	{
+		for (const int32 e : excluded)
+		{
+			if (e <= i)
+			{
+				++i;
+			}
+		}
+
+		return Point{ (i % width), (i / width) };
+	};
+
+	DefaultRNG rng{ seed };
+
+	if (cellCount <= (static_cast<int64>(bombs) * 8)) // 💣 の密度が高い場合
+	{
+		// 残りの 💣 の個数
+		int32 remaining = bombs;
+
+		for (int32 i = 0; (i < cellCount) && remaining; ++i)
+		{
+			if (Random(0, (cellCount - i - 1), rng) < remaining)
+			{
+				board.setMine(toPoint(i));
+
+				--remaining;
+			}
+		}
+	}
+	else
+	{
+		// 入れ替えによって値が変わったインデックス（記録されていない位置 i の値は i）
+		HashTable<int32, int32> swapped;
+		swapped.reserve(bombs);
+
+		const auto at = [&swapped](int32 i)
+		{
+			if (const auto it = swapped.find(i); it != swapped.end())
+			{
+				return it->second;
+			}
+
+			return i;
+		};
+
+		for (int32 i = 0; i < bombs; ++i)
+		{
+			const int32 k = Random(i, (cellCount - 1), rng);
+			const int32 index = at(k);
+
+			// i 番目と k 番目を入れ替える（i 番目は二度と参照しないので記録しない）
+			swapped[k] = at(i);
+
+			board.setMine(toPoint(index));
+		}
+	}
+}
+
+/// @brief 指定したマスを開きます。それが数字のないマス (0) であれば、つながっている数字のないマスとそれらに隣接するマスを幅優先探索で開きます。
+/// @param board 盤面
+/// @param start 開くマス
+/// @param queue 作業用の配列。呼び出しをまたいで再利用することでメモリ確保を減らせます
+/// @return 新たに開いたマスの個数
+inline int32 OpenCells(Board& board, const Point& start, Array<Point>& queue)
+{
+	// 指定したマスを開く
+	if (not board.open(start))
+	{
+		return 0;
+	}
+
+	// 新たに開いたマスの個数
+	int32 openedCount = 1;
+
+	// 数字のあるマスであれば、そのマスだけを開いて終わり
+	if (board.number(start) != 0)
+	{
+		return openedCount;
+	}
+
+	queue.clear();
+	queue << start;
+
+	// キューに積まれたマスはすべて開かれた数字のないマス (0)
+	for (size_t i = 0; i < queue.size(); ++i)
+	{
+		const Point pos = queue[i];
+
+		// その周囲のマスについて
+		for (const auto& offset : Offsets)
+		{
+			const Point neighbor = (pos + offset);
+
+			// 盤面の範囲内かつ未開放であれば、そのマスも開く
+			if (board.inBounds(neighbor) && board.open(neighbor))
+			{
+				++openedCount;
+
+				// それが数字のないマス (0) であれば、その周囲も開くためにキューに積む
+				if (board.number(neighbor) == 0)
+				{
+					queue << neighbor;
+				}
+			}
+		}
+	}
+
+	return openedCount;
+}
+
+/// @brief LabelOpenings() で並列化するマス目の数の下限
+constexpr size_t LabelingParallelThreshold = (1 << 20);
+
+/// @brief 等価なラベルの表をたどって、ラベルの根を返します。
+/// @param parent 仮のラベル → 等価なラベル
+/// @param label 仮のラベル
+/// @return 根のラベル
+/// @remark たどりながら経路を半分に縮めます。
+[[nodiscard]]
+inline int32 FindRootLabel(Array<int32>& parent, int32 label)
+{
+	while (parent[label] != label)
+	{
+		label = parent[label] = parent[parent[label]];
+	}
+
+	return label;
+}
+
+/// @brief 数字のないマス (0) の [beginY, endY) 行を、仮のラベルでラベル付けします。LabelOpenings() の 1 パス目です。
+/// @remark 仮のラベルは、その連結成分でラスタ順に最初に現れたマスのインデックスです。等価なラベルは parent で小さいほうにつなぎます。
+/// 帯の外の行は見ないので、ほかの帯を担当するスレッドと干渉しません。
+inline void LabelOpeningBand(const Board& board, Grid<int32>& labels, Array<int32>& parent, int32 beginY, int32 endY)
+{
+	const int32 w = board.width();
+
+	for (int32 y = beginY; y < endY; ++y)
+	{
+		for (int32 x = 0; x < w; ++x)
+		{
+			if (const PackedCell cell = board[Point{ x, y }];
+				cell.isMine() || (cell.adjacentMines() != 0))
+			{
+				labels[y][x] = -1;
+				continue;
+			}
+
+			// 左、左上、上、右上のラベル付け済みのマスのうち、最も小さいラベルを選び、残りをそれにつなぐ
+			int32 label = -1;
+
+			const auto merge = [&](int32 other)
+			{
+				if (other == -1)
+				{
+					return;
+				}
+
+				other = FindRootLabel(parent, other);
+
+				if (label == -1)
+				{
+					label = other;
+				}
+				else if (other != label)
+				{
+					parent[Max(label, other)] = Min(label, other);
+					label = Min(label, other);
+				}
+			};
+
+			if (0 < x)
+			{
+				merge(labels[y][x - 1]);
+			}
+
+			if (beginY < y)
+			{
+				for (int32 dx = -1; dx <= 1; ++dx)
+				{
+					if (InRange((x + dx), 0, (w - 1)))
+					{
+						merge(labels[y - 1][x + dx]);
+					}
+				}
+			}
+
+			if (label == -1) // 新しいラベル
+			{
+				label = (y * w + x);
+				parent[label] = label;
+			}
+
+			labels[y][x] = label;
+		}
+	}
+}
+
+/// @brief 数字のないマス (0) がつながった領域（クリック 1 回でまとめて開く領域）にラベルを付けます。
+/// @param board 盤面
+/// @param labels 各マスのラベルを書き込む配列。領域には 0 から始まる番号がラスタ順に付き、数字のあるマスと 💣 は -1 になります。
+/// @return 領域の個数
+/// @remark 2 パスのラスタ走査と等価ラベルの表によるラベリングです。大きな盤面では、行の帯ごとに並列にラベルを付けてから帯の境界で等価なラベルをつなぎ、最後の書き換えも帯ごとに並列に行います。
+inline int32 LabelOpenings(const Board& board, Grid<int32>& labels)
+{
+	const int32 w = board.width();
+	const int32 h = board.height();
+
+	labels.resize(board.size());
+
+	// 仮のラベル → 等価なラベル（仮のラベルが付いたインデックスだけが有効）
+	Array<int32> parent(static_cast<size_t>(w) * h);
+
+# if SIV3D_PLATFORM(WEB)
+
+	const int32 bandCount = 1;
+
+# else
+
+	const int32 bandCount = ((LabelingParallelThreshold <= parent.size())
+		? Min(h, static_cast<int32>(Threading::GetConcurrency())) : 1);
+
+# endif
+
+	const auto forEachBand = [&](auto f)
+	{
+		if (bandCount <= 1)
+		{
+			f(0, h);
+			return;
+		}
+
+		Array<AsyncTask<void>> tasks;
+
+		for (int32 i = 0; i < bandCount; ++i)
+		{
+			const int32 beginY = (h * i / bandCount);
+			const int32 endY = (h * (i + 1) / bandCount);
+			tasks << Async([=]() { f(beginY, endY); });
+		}
+
+		for (auto& task : tasks)
+		{
+			task.get();
+		}
+	};
+
+	// 1 パス目: 帯ごとに仮のラベルを付ける
+	forEachBand([&](int32 beginY, int32 endY) { LabelOpeningBand(board, labels, parent, beginY, endY); });
+
+	// 帯の境界をまたいでつながっているラベルをつなぐ
+	for (int32 i = 1; i < bandCount; ++i)
+	{
+		const int32 y = (h * i / bandCount);
+
+		for (int32 x = 0; x < w; ++x)
+		{
+			if (labels[y][x] == -1)
+			{
+				continue;
+			}
+
+			for (int32 dx = -1; dx <= 1; ++dx)
+			{
+				if (InRange((x + dx), 0, (w - 1)) && (labels[y - 1][x + dx] != -1))
+				{
+					const int32 a = FindRootLabel(parent, labels[y][x]);
+					const int32 b = FindRootLabel(parent, labels[y - 1][x + dx]);
+					parent[Max(a, b)] = Min(a, b);
+				}
+			}
+		}
+	}
+
+	// 等価なラベルの表を、0 から始まる番号の表に置き換える
+	// 根ではないラベルは自分より小さいラベルにつながっているので、小さい順に置き換えれば、つながり先はすでに番号になっている
+	int32 count = 0;
+
+	for (int32 y = 0; y < h; ++y)
+	{
+		for (int32 x = 0; x < w; ++x)
+		{
+			const int32 label = (y * w + x);
+
+			if (labels[y][x] != label) // 仮のラベルが付いたインデックスではない
+			{
+				continue;
+			}
+
+			parent[label] = ((parent[label] == label) ? count++ : parent[parent[label]]);
+		}
+	}
+
+	// 2 パス目: 仮のラベルを番号に書き換える
+	forEachBand([&](int32 beginY, int32 endY)
+		{
+			for (int32 y = beginY; y < endY; ++y)
+			{
+				for (int32 x = 0; x < w; ++x)
+				{
+					if (int32& label = labels[y][x];
+						label != -1)
+					{
+						label = parent[label];
+					}
+				}
+			}
+		});
+
+	return count;
+}
+
+/// @brief 盤面をクリアするのに必要な最小の左クリック数 (3BV) を返します。
+/// @param board 盤面
+/// @return 数字のないマスの領域の個数と、その領域に隣接しない数字マスの個数の和
+[[nodiscard]]
+inline int32 CountMinimumClicks(const Board& board)
+{
+	Grid<int32> labels;
+	int32 clicks = LabelOpenings(board, labels);
+
+	for (int32 y = 0; y < board.height(); ++y)
+	{
+		for (int32 x = 0; x < board.width(); ++x)
+		{
+			const Point pos{ x, y };
+
+			if (board[pos].isMine() || (labels[pos] != -1))
+			{
+				continue;
+			}
+
+			// 数字のないマスの領域を開けば一緒に開く数字マスは数えない
+			const bool adjacentToOpening = std::any_of(std::begin(Offsets), std::end(Offsets), [&](const Point& offset)
+				{
+					const Point neighbor = (pos + offset);
+					return (board.inBounds(neighbor) && (labels[neighbor] != -1));
+				});
+
+			if (not adjacentToOpening)
+			{
+				++clicks;
+			}
+		}
+	}
+
+	return clicks;
+}
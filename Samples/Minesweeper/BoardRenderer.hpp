@@ -0,0 +1,254 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Board.hpp"
+
+/// @brief 前回から状態が変わったマスを見つけるクラス
+/// @remark 描画とは独立しているので、ウィンドウなしでも使えます。
+class DirtyCellTracker
+{
+public:
+
+	/// @brief 前回の呼び出しから状態が変わったマスを集め、記録している状態を更新します。
+	/// @param board 盤面（状態が変わった行の記録を消去します）
+	/// @return 状態が変わったマス。初回と、盤面の大きさが変わったときはすべてのマス
+	/// @remark 盤面が記録している、状態が変わった行 (Board::dirtyRows()) だけを比べるので、かかる時間は盤面の大きさではなく、変わった行の数に比例します。
+	const Array<Point>& update(Board& board)
+	{
+		m_dirtyCells.clear();
+
+		if (m_snapshot.size() != board.size())
+		{
+			m_snapshot = Grid<PackedCell>(board.size());
+			m_valid = false;
+		}
+
+		const int32 w = board.width();
+
+		const auto collectRow = [&](int32 y)
+			{
+				const PackedCell* cells = board.row(y);
+				PackedCell* snapshot = m_snapshot[y];
+
+				for (int32 x = 0; x < w; ++x)
+				{
+					if ((not m_valid) || (cells[x].bits != snapshot[x].bits))
+					{
+						m_dirtyCells << Point{ x, y };
+						snapshot[x] = cells[x];
+					}
+				}
+			};
+
+		if (m_valid)
+		{
+			for (const int32 y : board.dirtyRows())
+			{
+				collectRow(y);
+			}
+		}
+		else
+		{
+			for (int32 y = 0; y < board.height(); ++y)
+			{
+				collectRow(y);
+			}
+		}
+
+		board.clearDirtyRows();
+		m_valid = true;
+
+		return m_dirtyCells;
+	}
+
+	/// @brief 次の update() ですべてのマスを変化したものとして扱うようにします。
+	void invalidate() noexcept
+	{
+		m_valid = false;
+	}
+
+private:
+
+	// 前回の update() のときの各マスの状態
+	Grid<PackedCell> m_snapshot;
+
+	// m_snapshot が有効であるか
+	bool m_valid = false;
+
+	// 状態が変わったマス
+	Array<Point> m_dirtyCells;
+};
+
+/// @brief 盤面をレンダーテクスチャに描いておき、状態が変わったマスだけを描き直すクラス
+/// @remark 大きな盤面は 1 枚のテクスチャの最大サイズを超えるので、盤面を MaxTilePixels ピクセル四方以下のタイルに分け、タイルごとにレンダーテクスチャを持ちます。
+/// タイルのレンダーテクスチャは、初めて画面に映ったときに作ってすべてのマスを描くので、画面に映らない部分のメモリは使いません。
+class BoardRenderer
+{
+public:
+
+	/// @brief 1 枚のタイルの一辺の最大ピクセル数（マスの大きさがこれより大きい場合は 1 マス）
+	static constexpr int32 MaxTilePixels = 1024;
+
+	BoardRenderer() = default;
+
+	/// @brief レンダラーを作成します。
+	/// @param boardSize 盤面のマス目の数
+	/// @param cellSize マスの大きさ（ピクセル）
+	/// @param backgroundColor マスの隙間の色
+	BoardRenderer(const Size& boardSize, const Size& cellSize, const ColorF& backgroundColor)
+		: m_boardSize{ boardSize }
+		, m_cellSize{ cellSize }
+		, m_tileCells{ Max((MaxTilePixels / cellSize.x), 1), Max((MaxTilePixels / cellSize.y), 1) }
+		, m_tiles(((boardSize.x + m_tileCells.x - 1) / m_tileCells.x), ((boardSize.y + m_tileCells.y - 1) / m_tileCells.y))
+		, m_backgroundColor{ backgroundColor } {}
+
+	/// @brief 画面に初めて映ったタイルを作り、状態が変わったマスだけをレンダーテクスチャに描き直します。
+	/// @param board 盤面（状態が変わった行の記録を消去します）
+	/// @param pos 盤面を描く位置
+	/// @param drawCell マスを描く関数 (PackedCell, const Rect&)
+	/// @return 描き直したマスの個数
+	/// @remark 描き直すマスはタイルごとにまとめて描くので、描画先の切り替えは、描き直すマスの数ではなくタイルの数だけで済みます。
+	template <class DrawCell>
+	size_t update(Board& board, const Point& pos, DrawCell drawCell)
+	{
+		size_t drawnCount = 0;
+
+		// 状態が変わったマスのうち、作ってあるタイルのものをタイルごとにまとめる
+		m_dirtyCells.clear();
+
+		for (const auto& cellPos : m_tracker.update(board))
+		{
+			const Point tile = (cellPos / m_tileCells);
+
+			if (not m_tiles[tile].isEmpty())
+			{
+				m_dirtyCells.emplace_back(static_cast<int32>(tile.y * m_tiles.width() + tile.x), cellPos);
+			}
+		}
+
+		std::stable_sort(m_dirtyCells.begin(), m_dirtyCells.end(), [](const auto& a, const auto& b) { return (a.first < b.first); });
+
+		// 描画先の切り替えがタイルごとに 1 回で済むように、タイルごとにまとめて描き直す
+		for (auto it = m_dirtyCells.begin(); it != m_dirtyCells.end();)
+		{
+			const Point tile = (it->second / m_tileCells);
+			const ScopedRenderTarget2D target{ m_tiles[tile] };
+
+			for (const int32 tileIndex = it->first; (it != m_dirtyCells.end()) && (it->first == tileIndex); ++it)
+			{
+				drawCellAt(board, it->second, tile, drawCell);
+				++drawnCount;
+			}
+		}
+
+		// 画面に初めて映ったタイルを作って、すべてのマスを描く
+		forEachVisibleTile(pos, [&](const Point& tile)
+			{
+				if (not m_tiles[tile].isEmpty())
+				{
+					return;
+				}
+
+				const Rect cells = tileCells(tile);
+
+				// 不透明な色で初期化しておけば、その後の描画でテクスチャのアルファ値は 1 のまま変わらない
+				m_tiles[tile] = RenderTexture{ (cells.size * m_cellSize), m_backgroundColor };
+
+				const ScopedRenderTarget2D target{ m_tiles[tile] };
+
+				for (int32 y = cells.y; y < cells.bottomY(); ++y)
+				{
+					for (int32 x = cells.x; x < cells.rightX(); ++x)
+					{
+						drawCellAt(board, Point{ x, y }, tile, drawCell);
+						++drawnCount;
+					}
+				}
+			});
+
+		return drawnCount;
+	}
+
+	/// @brief レンダーテクスチャに描いた盤面のうち、画面に映るタイルを描きます。
+	/// @param pos 描く位置
+	void draw(const Point& pos) const
+	{
+		forEachVisibleTile(pos, [&](const Point& tile)
+			{
+				if (not m_tiles[tile].isEmpty())
+				{
+					m_tiles[tile].draw(pos + tileCells(tile).pos * m_cellSize);
+				}
+			});
+	}
+
+	/// @brief マスの大きさを返します。
+	[[nodiscard]]
+	const Size& cellSize() const noexcept
+	{
+		return m_cellSize;
+	}
+
+private:
+
+	Size m_boardSize{ 0, 0 };
+
+	Size m_cellSize{ 0, 0 };
+
+	// 1 枚のタイルのマス目の数
+	Size m_tileCells{ 1, 1 };
+
+	// タイルごとのレンダーテクスチャ（まだ画面に映っていないタイルは空）
+	Grid<RenderTexture> m_tiles;
+
+	ColorF m_backgroundColor{ 0.5 };
+
+	DirtyCellTracker m_tracker;
+
+	// 描き直すマスと、そのマスを含むタイルのインデックス（フレームごとに使い回す）
+	Array<std::pair<int32, Point>> m_dirtyCells;
+
+	// タイルに含まれるマスの範囲を返す（盤面の端のタイルは小さくなる）
+	[[nodiscard]]
+	Rect tileCells(const Point& tile) const
+	{
+		const Point tl = (tile * m_tileCells);
+		return Rect{ tl, (Min((tl.x + m_tileCells.x), m_boardSize.x) - tl.x), (Min((tl.y + m_tileCells.y), m_boardSize.y) - tl.y) };
+	}
+
+	// 盤面を pos に描くときに画面に映るタイルを列挙する
+	template <class Fty>
+	void forEachVisibleTile(const Point& pos, Fty f) const
+	{
+		if (m_tiles.isEmpty())
+		{
+			return;
+		}
+
+		const Size tilePixels = (m_tileCells * m_cellSize);
+		const Rect scene{ -pos, Scene::Size() };
+		const int32 x0 = Clamp((scene.x / tilePixels.x), 0, (static_cast<int32>(m_tiles.width()) - 1));
+		const int32 x1 = Clamp(((scene.rightX() - 1) / tilePixels.x), 0, (static_cast<int32>(m_tiles.width()) - 1));
+		const int32 y0 = Clamp((scene.y / tilePixels.y), 0, (static_cast<int32>(m_tiles.height()) - 1));
+		const int32 y1 = Clamp(((scene.bottomY() - 1) / tilePixels.y), 0, (static_cast<int32>(m_tiles.height()) - 1));
+
+		for (int32 y = y0; y <= y1; ++y)
+		{
+			for (int32 x = x0; x <= x1; ++x)
+			{
+				f(Point{ x, y });
+			}
+		}
+	}
+
+	// 指定したマスを、そのマスを含むタイルのレンダーテクスチャに描く（描画先は呼び出し元で設定しておく）
+	template <class DrawCell>
+	void drawCellAt(const Board& board, const Point& cellPos, const Point& tile, DrawCell drawCell) const
+	{
+		const Rect cell{ (m_cellSize * (cellPos - tileCells(tile).pos)), m_cellSize };
+
+		// 前の絵を消してから描く
+		cell.draw(m_backgroundColor);
+
+		drawCell(board[cellPos], cell);
+	}
+};
@@ -0,0 +1,182 @@
+# pragma once
+# include <Siv3D.hpp>
+# include <atomic>
+# include "Board.hpp"
+# include "Solver.hpp"
+
+// ゲームの状態
+enum class GameState
+{
+	Game,		// ゲームが進行中
+	Failed,		// ゲームオーバー
+	Cleared,	// ゲームクリア
+};
+
+// 盤面の生成方法
+enum class GeneratorMode
+{
+	Classic,	// 完全にランダム（最初に開いたマスが 💣 のこともある）
+	NoGuess,	// 最初に開いたマスとその周囲は安全で、推測なしで解ける
+	Infinite,	// 無限に広い盤面（必要な部分だけをチャンク単位で生成する）
+};
+
+// 盤面を生成する関数（同じシードからは同じ盤面が生成される）
+inline Board MakeGame(const Size& size, int32 bombs, uint64 seed)
+{
+	// 盤面を作成する
+	Board board{ size };
+
+	// 指定された個数だけ 💣 を設置する
+	PlaceMines(board, bombs, seed);
+
+	// すべてのマスについて、周囲の 💣 の個数を計算する
+	board.updateAdjacentMines();
+
+	return board;
+}
+
+// 盤面のシードと試行番号から、候補の盤面のシードを求める関数
+// 単に足すと、シード s の k 番目の候補とシード s + 1 の k - 1 番目の候補が同じ盤面になるので、SplitMix64 で混ぜる
+[[nodiscard]]
+inline uint64 MakeCandidateSeed(uint64 seed, int32 attempt) noexcept
+{
+	uint64 h = (seed + (static_cast<uint64>(attempt) + 1) * 0x9E3779B97F4A7C15ULL);
+	h = ((h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL);
+	h = ((h ^ (h >> 27)) * 0x94D049BB133111EBULL);
+	return (h ^ (h >> 31));
+}
+
+// 最初に開くマスとその周囲が安全で、推測なしで解ける盤面を生成する関数（同じシードからは同じ盤面が生成される）
+// 候補の盤面を複数のスレッドで並列に生成してソルバーで解き、推測なしで解けたもののうち試行番号が最も小さいものを選ぶ
+// 試行回数の上限までに見つからなかった場合は、最初に開くマスとその周囲が安全なだけの盤面を返し、solvable を false にする
+inline Board MakeNoGuessGame(const Size& size, int32 bombs, const Point& firstClick, uint64 seed, bool& solvable)
+{
+	// 試行回数の上限（💣 の密度が高いと、推測なしで解ける盤面が存在しないことがある）
+	constexpr int32 MaxAttempts = 10000;
+
+	// attempt 番目の候補の盤面
+	const auto makeCandidate = [&](int32 attempt)
+	{
+		Board board{ size };
+		PlaceMines(board, bombs, MakeCandidateSeed(seed, attempt), firstClick);
+		board.updateAdjacentMines();
+		return board;
+	};
+
+	// 推測なしで解けた候補の試行番号の最小値
+	std::atomic<int32> found = MaxAttempts;
+
+	// first, first + step, first + 2 * step, ... 番目の候補を順に試す
+	// ほかのスレッドがより小さい試行番号で見つけたら打ち切る
+	const auto search = [&](int32 first, int32 step)
+	{
+		for (int32 attempt = first; attempt < found; attempt += step)
+		{
+			if (IsSolvableWithoutGuessing(makeCandidate(attempt), firstClick, bombs))
+			{
+				int32 current = found;
+
+				while ((attempt < current) && (not found.compare_exchange_weak(current, attempt))) {}
+
+				return;
+			}
+		}
+	};
+
+# if SIV3D_PLATFORM(WEB)
+
+	search(0, 1);
+
+# else
+
+	const int32 threadCount = Max(1, static_cast<int32>(Threading::GetConcurrency()));
+
+	Array<AsyncTask<void>> tasks;
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		tasks << Async(search, i, threadCount);
+	}
+
+	for (auto& task : tasks)
+	{
+		task.get();
+	}
+
+# endif
+
+	solvable = (found < MaxAttempts);
+
+	return makeCandidate(solvable ? found.load() : 0);
+}
+
+// プレイヤーの操作
+enum class Action : uint8
+{
+	Open,	// マスを開く
+	Flag,	// 旗の状態を反転する
+};
+
+// 盤面に操作を適用する関数。操作が盤面を変えた場合 true を返す
+// NoGuess モードで推測なしで解ける盤面が見つからなかった場合は、mayNeedGuess を true にする
+// ウィンドウの入力とは独立しているので、リプレイの再生やベンチマークでも使える
+inline bool ApplyAction(GameState& gameState, Board& board, const GeneratorMode generatorMode, const int32 bombCount, const uint64 seed, int32& unopenedCount, bool& mayNeedGuess, Array<Point>& openQueue, const Point& pos, const Action action)
+{
+	if (action == Action::Flag)
+	{
+		// 旗の状態を反転
+		board.toggleFlag(pos);
+		return true;
+	}
+
+	// 開かれているマスと、旗のあるマスは開かない
+	if (board[pos].isOpened() || board[pos].isFlagged())
+	{
+		return false;
+	}
+
+	// NoGuess モードでは、最初に開くマスが決まってから盤面を生成する
+	if ((generatorMode == GeneratorMode::NoGuess) && (unopenedCount == board.size().area()))
+	{
+		bool solvable = false;
+		Board generated = MakeNoGuessGame(board.size(), bombCount, pos, seed, solvable);
+		mayNeedGuess = (not solvable);
+
+		// 最初のクリックより前に立てた旗を引き継ぐ
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				if (board[Point{ x, y }].isFlagged())
+				{
+					generated.toggleFlag(Point{ x, y });
+				}
+			}
+		}
+
+		board = std::move(generated);
+	}
+
+	// そのマスを開く。数字のないマス (0) であれば、つながっている数字のないマスと、それらに隣接するマスも開く
+	unopenedCount -= OpenCells(board, pos, openQueue);
+
+	// そのマスが 💣 であれば
+	if (board[pos].isMine())
+	{
+		// ゲームオーバーにする
+		gameState = GameState::Failed;
+
+		// 爆発したフラグを立てる
+		board.explode(pos);
+
+		// すべての 💣 マスを開く
+		unopenedCount -= board.openAllMines();
+	}
+	else if (unopenedCount == bombCount)
+	{	// 開かれていないマスの個数が爆弾の個数と一致すれば
+		// ゲームクリアにする
+		gameState = GameState::Cleared;
+	}
+
+	return true;
+}
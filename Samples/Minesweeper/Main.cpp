@@ -1,335 +1,328 @@
 # include <Siv3D.hpp> // OpenSiv3D v0.6.5
+# include "Benchmark.hpp"
+# include "Board.hpp"
+# include "BoardRenderer.hpp"
+# include "Game.hpp"
+# include "Replay.hpp"
+# include "Solver.hpp"
+# include "World.hpp"
 
-// ゲームの状態
-enum class GameState
-{
-	Game,		// ゲームが進行中
-	Failed,		// ゲームオーバー
-	Cleared,	// ゲームクリア
-};
-
-// セルの状態
-struct CellState
-{
-	// 開かれている
-	bool opened = false;
-
-	// 旗が立てられている
-	bool flagged = false;
+# if defined(MINESWEEPER_BENCHMARK)
 
-	// 爆発した
-	bool exploded = false;
+// MINESWEEPER_BENCHMARK を定義してビルドすると、ウィンドウを作らずにベンチマークだけを実行する
+SIV3D_SET(EngineOption::Renderer::Headless)
 
-	// 島番号（数字のないマスを一気に開くときに使う）
-	int32 groupIndex = 0;
-};
+# endif
 
-// 周囲のマスへのオフセット
-constexpr Point Offsets[8] =
+// 開いていないセルのブロックを描く関数
+void DrawBlock(const Rect& rect)
 {
-	{ -1, -1 }, { 0, -1 }, { 1, -1 },
-	{ -1,  0 }           , { 1,  0 },
-	{ -1,  1 }, { 0,  1 }, { 1,  1 },
-};
+	Triangle{ rect.tl(), rect.tr(), rect.bl() }.draw(ColorF{ 1.0 });
+	Triangle{ rect.tr(), rect.br(), rect.bl() }.draw(ColorF{ 0.5 });
+	rect.stretched(-5).draw(ColorF{ 0.75 });
+}
 
-// 指定したマス目の周囲にある 💣 (-1) の個数を返す関数
-int32 GetBombCount(const Grid<int32>& grid, const Point& center)
+// 1 マスを描画する関数
+void DrawCell(const PackedCell state, const Rect& cell, const Font& font, const Texture& bombTexture, const Texture& flagTexture)
 {
-	// 自身が 💣 (-1) なら -1 を返す
-	if (grid[center] == -1)
+	// 0～8 の数字の色
+	constexpr ColorF NumberColors[9] =
 	{
-		return -1;
-	}
-
-	// 見つかった 💣 (-1) の個数
-	int32 bombCount = 0;
+		ColorF{ 0, 0, 0 }, ColorF{ 0, 0, 1 }, ColorF{ 0, 0.5, 0 }, ColorF{ 1, 0, 0 },
+		ColorF{ 0, 0, 0.5 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }
+	};
 
-	for (const auto& offset : Offsets)
+	if (state.isOpened()) // 開かれている
 	{
-		// 調べるマス
-		const Point pos = (center + offset);
+		// 背景を描く
+		cell.stretched(-1).draw(ColorF{ 0.75 });
 
-		// grid.fetch(pos, defaultValue) は、
-		// pos が範囲内の場合 grid[pos] を返し、それ以外の場合は defaultValue を返す
-		if (grid.fetch(pos, 0) == -1) // 💣 (-1) の場合
+		if (const int32 n = state.number();
+			n == -1) // 💣 (-1) マスであれば
+		{
+			// 爆発箇所であればセルを赤に
+			if (state.isExploded())
+			{
+				cell.stretched(-1).draw(ColorF{ 1, 0, 0 });
+			}
+
+			// 爆弾を描く
+			bombTexture.resized(36).drawAt(cell.center());
+		}
+		else if (1 <= n) // 1 以上の数字マスであれば
 		{
-			++bombCount;
+			// 数字を描く
+			font(n).drawAt(cell.center(), NumberColors[n]);
 		}
 	}
+	else // 開かれていない
+	{
+		// ブロックを描く
+		DrawBlock(cell);
 
-	return bombCount;
+		// 旗が立てられているなら旗を描く
+		if (state.isFlagged())
+		{
+			flagTexture.resized(30).drawAt(cell.center());
+		}
+	}
 }
 
-// 盤面を生成する関数
-Grid<int32> MakeGame(const Size& size, int32 bombs)
+// 盤面を描画する関数
+void DrawGame(BoardRenderer& renderer, Board& board, const Font& font, const Texture& bombTexture, const Texture& flagTexture, const Point& gamePos)
 {
-	// 盤面の二次元配列を作成する
-	Grid<int32> grid(size);
-
-	// 指定された個数だけ 💣 (-1) を設置する
-	while (bombs)
-	{
-		// 二次元配列上のランダムな位置
-		const Point pos = RandomPoint((size.x - 1), (size.y - 1));
+	// 状態が変わったマスだけをレンダーテクスチャに描き直す
+	renderer.update(board, gamePos, [&](const PackedCell state, const Rect& cell) { DrawCell(state, cell, font, bombTexture, flagTexture); });
 
-		// 未設置であれば
-		if (grid[pos] == 0)
-		{
-			// 💣 (-1) を設置する
-			grid[pos] = -1;
+	// レンダーテクスチャに描いた盤面を描く
+	renderer.draw(gamePos);
 
-			// 残りの 💣 の個数を減らす
-			--bombs;
-		}
-	}
+	// マウスカーソルの下にある開かれていないマスを明るくする（毎フレーム変わるので、レンダーテクスチャには描かない）
+	const Size& cellSize = renderer.cellSize();
+	const Rect gameArea{ gamePos, (board.size() * cellSize - Point{ 1, 1 }) };
 
-	// すべてのマスについて
-	for (int32 y = 0; y < size.y; ++y)
+	if (gameArea.mouseOver())
 	{
-		for (int32 x = 0; x < size.x; ++x)
+		if (const Point pos = ((Cursor::Pos() - gamePos) / cellSize);
+			not board[pos].isOpened())
 		{
-			// 数字を計算する。ただし、💣 マスは -1 のまま
-			grid[y][x] = GetBombCount(grid, Point{ x, y });
+			Rect{ (gamePos + (cellSize * pos)), cellSize }.stretched(-5).draw(ColorF{ 1.0, 0.25 });
 		}
 	}
-
-	return grid;
 }
 
-// 盤面の状態を作成する関数
-Grid<CellState> MakeStates(const Grid<int32>& grid)
+// 盤面を更新する関数
+void UpdateGame(GameState& gameState, Board& board, const GeneratorMode generatorMode, const int32 bombCount, const uint64 seed, int32& unopenedCount, bool& mayNeedGuess, Array<Point>& openQueue, ReplayRecorder& recorder, const Point& gamePos, const Size& cellSize)
 {
-	const Size size = grid.size();
+	// 盤面の領域
+	const Rect gameArea{ gamePos, (board.size() * cellSize - Point{ 1, 1 }) };
 
-	// 盤面と同じ大きさの二次元配列
-	Grid<CellState> states(size);
+	// 盤面が左クリックされた
+	const bool open = gameArea.leftClicked();
 
-	// 各マスの接続状況を管理するデータ構造
-	DisjointSet<int32> ds{ states.num_elements() };
+	// 盤面が右クリックされた
+	const bool flag = gameArea.rightClicked();
 
-	// すべてのマスについて
-	for (int32 y = 0; y < size.y; ++y)
+	if (open || flag)
 	{
-		for (int32 x = 0; x < size.x; ++x)
-		{
-			// 自身のマスのインデックス
-			const int32 index = static_cast<int32>(y * size.x + x);
+		// クリックされたマスの位置
+		const Point pos = ((Cursor::Pos() - gamePos) / cellSize);
 
-			// 自身が 0 のマスで
-			if (grid[y][x] == 0)
-			{
-				// 右のマスが 0 なら
-				if (int nx = (x + 1);
-					(nx < size.x) && (grid[y][nx] == 0))
-				{
-					const int32 east = (index + 1); // 右のマスのインデックス
-					ds.merge(index, east); // 右のマスを同じ島にする
-				}
+		const Action action = (open ? Action::Open : Action::Flag);
 
-				// 下のマスが 0 なら
-				if (int ny = (y + 1);
-					(ny < size.y) && (grid[ny][x] == 0))
-				{
-					const int32 south = (index + size.x); // 下のマスのインデックス
-					ds.merge(index, south); // 下のマスを同じ島にする
-				}
-			}
+		// 盤面を変えた操作をリプレイに記録する
+		if (ApplyAction(gameState, board, generatorMode, bombCount, seed, unopenedCount, mayNeedGuess, openQueue, pos, action))
+		{
+			recorder.record(pos, action);
 		}
 	}
+}
+
+// 画面上の盤面の領域に映っているマスの範囲を返す関数
+Rect VisibleCells(const Vec2& camera, const Rect& gameArea, const Size& cellSize)
+{
+	const Point tl{ static_cast<int32>(Floor(camera.x / cellSize.x)), static_cast<int32>(Floor(camera.y / cellSize.y)) };
+	const Point br{ static_cast<int32>(Floor((camera.x + gameArea.w) / cellSize.x)), static_cast<int32>(Floor((camera.y + gameArea.h) / cellSize.y)) };
+	return{ tl, (br - tl + Point{ 1, 1 }) };
+}
+
+// 無限に広い盤面を更新する関数
+void UpdateWorld(GameState& gameState, World& world, int32& openedCount, Array<Point>& openQueue, const Vec2& camera, const Rect& gameArea, const Size& cellSize)
+{
+	// 盤面が左クリックされた
+	const bool open = gameArea.leftClicked();
 
+	// 盤面が右クリックされた
+	const bool flag = gameArea.rightClicked();
+
+	if (open || flag)
 	{
-		// マスのインデックス
-		int32 index = 0;
+		// クリックされたマスの位置（カメラの位置はピクセル単位）
+		const Vec2 worldPos = (Cursor::PosF() - gameArea.pos + camera);
+		const Point pos{ static_cast<int32>(Floor(worldPos.x / cellSize.x)), static_cast<int32>(Floor(worldPos.y / cellSize.y)) };
 
-		// すべてのマスについて
-		for (int32 y = 0; y < size.y; ++y)
+		if (open && (not world[pos].isOpened()) && (not world[pos].isFlagged())) // 開かれていない、旗のないマスが左クリックされた
 		{
-			for (int32 x = 0; x < size.x; ++x)
-			{
-				// 島番号を割り当て
-				states[y][x].groupIndex = ds.find(index);
+			// そのマスを開く。数字のないマス (0) であれば、チャンクの境界をまたいで周囲も開く
+			openedCount += OpenCells(world, pos, openQueue);
 
-				++index;
+			// そのマスが 💣 であればゲームオーバーにする
+			if (world[pos].isMine())
+			{
+				gameState = GameState::Failed;
+				world.explode(pos);
 			}
 		}
+		else if (flag) // 右クリックされた
+		{
+			// 旗の状態を反転
+			world.toggleFlag(pos);
+		}
 	}
-
-	return states;
 }
 
-// 開いていないセルのブロックを描く関数
-void DrawBlock(const Rect& rect)
+// 映っている範囲の周囲 1 チャンクより遠くにある、触れていないチャンクを捨てる関数
+// （ゲームオーバー後もスクロールと描画でチャンクが作られるので、ゲームの状態によらず毎フレーム呼ぶ）
+void EvictDistantChunks(World& world, const Vec2& camera, const Rect& gameArea, const Size& cellSize)
 {
-	Triangle{ rect.tl(), rect.tr(), rect.bl() }.draw(ColorF{ 1.0 });
-	Triangle{ rect.tr(), rect.br(), rect.bl() }.draw(ColorF{ 0.5 });
-	rect.stretched(-5).draw(ColorF{ 0.75 });
+	const Rect visibleCells = VisibleCells(camera, gameArea, cellSize);
+	const Point tl = World::ChunkCoord(visibleCells.tl());
+	const Point br = World::ChunkCoord(visibleCells.br() - Point{ 1, 1 });
+	world.evict(Rect{ tl, (br - tl + Point{ 1, 1 }) }.stretched(1));
 }
 
-// 盤面を描画する関数
-void DrawGame(const Grid<int32>& grid, const Grid<CellState>& states, const Font& font, const Texture& bombTexture, const Texture& flagTexture, const Point& gamePos, const Size& cellSize)
+// 無限に広い盤面を描画する関数
+void DrawWorld(const GameState gameState, World& world, const Font& font, const Texture& bombTexture, const Texture& flagTexture, const Vec2& camera, const Rect& gameArea, const Size& cellSize)
 {
-	// 0～8 の数字の色
-	constexpr ColorF NumberColors[9] =
-	{
-		ColorF{ 0, 0, 0 }, ColorF{ 0, 0, 1 }, ColorF{ 0, 0.5, 0 }, ColorF{ 1, 0, 0 },
-		ColorF{ 0, 0, 0.5 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }, ColorF{ 0.5, 0, 0 }
-	};
+	const Rect visibleCells = VisibleCells(camera, gameArea, cellSize);
 
-	// すべてのマスについて
-	for (int32 y = 0; y < grid.height(); ++y)
+	// 盤面の領域の外にはみ出したマスを描かないようにする
+	const ScopedViewport2D viewport{ gameArea };
+
+	for (int32 y = visibleCells.y; y < visibleCells.bottomY(); ++y)
 	{
-		for (int32 x = 0; x < grid.width(); ++x)
+		for (int32 x = visibleCells.x; x < visibleCells.rightX(); ++x)
 		{
-			const auto& state = states[y][x];
+			PackedCell state = world[Point{ x, y }];
 
-			// セルの左上座標
-			const Point pos = (gamePos + (cellSize * Point{ x, y }));
-
-			// セルの領域
-			const Rect cell{ pos, cellSize };
-
-			if (state.opened) // 開かれている
+			// ゲームオーバーになったら、映っている 💣 マスを開いて見せる
+			if ((gameState == GameState::Failed) && state.isMine())
 			{
-				// 背景を描く
-				cell.stretched(-1).draw(ColorF{ 0.75 });
-
-				if (const int32 n = grid[y][x];
-					n == -1) // 💣 (-1) マスであれば
-				{
-					// 爆発箇所であればセルを赤に
-					if (state.exploded)
-					{
-						cell.stretched(-1).draw(ColorF{ 1, 0, 0 });
-					}
-
-					// 爆弾を描く
-					bombTexture.resized(36).drawAt(cell.center());
-				}
-				else if (1 <= n) // 1 以上の数字マスであれば
-				{
-					// 数字を描く
-					font(n).drawAt(cell.center(), NumberColors[n]);
-				}
+				state.bits |= PackedCell::OpenedBit;
 			}
-			else // 開かれていない
-			{
-				// ブロックを描く
-				DrawBlock(cell);
 
-				// 旗が立てられているなら旗を描く
-				if (state.flagged)
-				{
-					flagTexture.resized(30).drawAt(cell.center());
-				}
-			}
+			// セルの左上座標
+			const Vec2 pos = ((cellSize * Point{ x, y }) - camera);
+
+			DrawCell(state, Rect{ pos.asPoint(), cellSize }, font, bombTexture, flagTexture);
 		}
 	}
 }
 
-// 指定された島番号のマスと、それらに隣接するマスを開く関数
-void OpenGroup(const Grid<int32>& grid, Grid<CellState>& states, const int32 groupIndex)
+// 無限に広い盤面で遊ぶ関数
+void RunInfiniteGame(const Font& font, const Texture& bombTexture, const Texture& flagTexture, const std::array<Texture, 3>& faceTextures, const Size& cellSize)
 {
-	// すべてのマスについて
-	for (int32 y = 0; y < grid.height(); ++y)
-	{
-		for (int32 x = 0; x < grid.width(); ++x)
-		{
-			auto& state = states[y][x];
+	// 💣 の密度
+	constexpr double Density = 0.16;
 
-			// 指定された島番号のマスであれば
-			if (state.groupIndex == groupIndex)
-			{
-				// 開く
-				state.opened = true;
+	// スクロールの速さ（ピクセル / 秒）
+	constexpr double ScrollSpeed = 800.0;
 
-				// その周囲のマスについて
-				for (const auto& offset : Offsets)
-				{
-					const Point neighbor = (Point{ x, y } + offset);
+	// 盤面を描く領域
+	const Rect gameArea{ 0, 80, Scene::Width(), (Scene::Height() - 80) };
 
-					// 盤面の範囲内かつ未開放であれば, そのマスも開く
-					if (grid.inBounds(neighbor) && (not states[neighbor].opened))
-					{
-						states[neighbor].opened = true;
-
-						// それが異なる島番号の数字のないマス (0) であれば, 再帰的にそれらも開く
-						if ((grid[neighbor] == 0) && (groupIndex != states[neighbor].groupIndex))
-						{
-							OpenGroup(grid, states, states[neighbor].groupIndex);
-						}
-					}
-				}
-			}
-		}
-	}
-}
+	// 原点のマス（最初は安全）が盤面の領域の中央に来るカメラの位置
+	const Vec2 initialCamera = ((cellSize / 2) - gameArea.size / 2);
 
-// 盤面を更新する関数
-void UpdateGame(GameState& gameState, const Grid<int32>& grid, Grid<CellState>& states, const int32 bombCount, const Point& gamePos, const Size& cellSize)
-{
-	// 盤面の領域
-	const Rect gameArea{ gamePos, (grid.size() * cellSize - Point{ 1, 1 }) };
+	// 盤面を作成する
+	World world{ RandomUint64(), Density };
 
-	// 盤面が左クリックされた
-	const bool open = gameArea.leftClicked();
+	// ゲームの状態
+	GameState gameState = GameState::Game;
 
-	// 盤面が右クリックされた
-	const bool flag = gameArea.rightClicked();
+	// 開いたマスの個数（スコア）
+	int32 openedCount = 0;
 
-	if (open || flag)
-	{
-		// クリックされたマスの位置
-		const Point pos = ((Cursor::Pos() - gamePos) / cellSize);
+	// マスを開くときに使う作業用の配列
+	Array<Point> openQueue;
 
-		if (open && (not states[pos].opened) && (not states[pos].flagged)) // 開かれていない、旗のないマスが左クリックされた
+	// 盤面の領域の左上に映すワールド座標（ピクセル）
+	Vec2 camera = initialCamera;
+
+	// 顔ボタンの領域
+	const Rect faceButton{ Arg::center(Scene::Width() / 2, 40), 72 };
+
+	while (System::Update())
+	{
+		////////////////////////////////
+		//
+		//	状態の更新
+		//
+		////////////////////////////////
 		{
-			// そのマスを開く
-			states[pos].opened = true;
+			// 矢印キーでスクロールする
+			camera += (Vec2{ (KeyRight.pressed() - KeyLeft.pressed()), (KeyDown.pressed() - KeyUp.pressed()) } * ScrollSpeed * Scene::DeltaTime());
 
-			// そのマスが数字のないマス (0) であれば
-			if (grid[pos] == 0)
+			// ゲームが進行中なら盤面を更新
+			if (gameState == GameState::Game)
 			{
-				// 同じ島番号のマスと、それらに隣接するマスも開く
-				OpenGroup(grid, states, states[pos].groupIndex);
+				UpdateWorld(gameState, world, openedCount, openQueue, camera, gameArea, cellSize);
 			}
 
-			// そのマスが 💣 (-1) であれば
-			if (grid[pos] == -1)
+			// 顔ボタンが押されたら状態を初期化
+			if (faceButton.leftClicked())
 			{
-				// ゲームオーバーにする
-				gameState = GameState::Failed;
-
-				// 爆発したフラグを立てる
-				states[pos].exploded = true;
-
-				// すべての 💣 マスを開く
-				for (int32 y = 0; y < grid.height(); ++y)
-				{
-					for (int32 x = 0; x < grid.width(); ++x)
-					{
-						if (grid[y][x] == -1)
-						{
-							states[y][x].opened = true;
-						}
-					}
-				}
-			}
-			else if (states.count_if([](const CellState& c) { return (not c.opened); }) == bombCount)
-			{	// 開かれていないマスの個数が爆弾の個数と一致すれば
-				// ゲームクリアにする
-				gameState = GameState::Cleared;
+				world = World{ RandomUint64(), Density };
+				openedCount = 0;
+				camera = initialCamera;
+				gameState = GameState::Game;
 			}
+
+			// 遠くのチャンクを捨てる
+			EvictDistantChunks(world, camera, gameArea, cellSize);
 		}
-		else if (flag) // 右クリックされた
+
+		////////////////////////////////
+		//
+		//	描画
+		//
+		////////////////////////////////
 		{
-			// 旗の状態を反転
-			states[pos].flagged = (not states[pos].flagged);
+			// 盤面を描く
+			DrawWorld(gameState, world, font, bombTexture, flagTexture, camera, gameArea, cellSize);
+
+			// UI エリアの背景を描く
+			Rect{ Scene::Width(), 80 }.draw(ColorF{ 0.75 });
+			{
+				// 顔ボタンを描く
+				DrawBlock(faceButton);
+
+				// 顔を描く
+				faceTextures[FromEnum(gameState)].resized(60).drawAt(faceButton.center());
+
+				// 開いたマスの個数と、メモリ上にあるチャンクの個数を描く
+				font(U"{}"_fmt(openedCount)).draw(24, Arg::leftCenter(20, 40), ColorF{ 0.1 });
+				font(U"{} chunks"_fmt(world.chunkCount())).draw(16, Arg::rightCenter((Scene::Width() - 20), 40), ColorF{ 0.3 });
+			}
 		}
 	}
 }
 
+// 固定のシードから生成した盤面を自動でプレイし、ゲームの処理の速さをコンソールに出力する関数
+void RunBenchmarks()
+{
+	const Array<BenchmarkConfig> configs =
+	{
+		{ .size = { 9, 9 }, .mineCount = 10, .boardCount = 100000, .policy = BenchmarkPolicy::RandomSafe },
+		{ .size = { 30, 16 }, .mineCount = 99, .boardCount = 10000, .policy = BenchmarkPolicy::RandomSafe },
+		{ .size = { 30, 16 }, .mineCount = 99, .boardCount = 1000, .policy = BenchmarkPolicy::Solver },
+		{ .size = { 30, 16 }, .mineCount = 99, .boardCount = 1000, .generatorMode = GeneratorMode::NoGuess, .policy = BenchmarkPolicy::Solver },
+		{ .size = { 1000, 1000 }, .mineCount = 160000, .boardCount = 10, .policy = BenchmarkPolicy::RandomSafe },
+	};
+
+	constexpr StringView GeneratorModeNames[3] = { U"Classic", U"NoGuess", U"Infinite" };
+	constexpr StringView PolicyNames[2] = { U"Solver", U"RandomSafe" };
+
+	Console << U"size, mines, generator, policy, boards, cleared, may need guess, boards/s, clicks/s, p50 [us], p99 [us]";
+
+	for (const auto& config : configs)
+	{
+		const BenchmarkResult result = RunBenchmark(config);
+
+		Console << U"{}x{}, {}, {}, {}, {}, {}, {}, {:.1f}, {:.1f}, {:.2f}, {:.2f}"_fmt(config.size.x, config.size.y, config.mineCount,
+			GeneratorModeNames[FromEnum(config.generatorMode)], PolicyNames[FromEnum(config.policy)],
+			result.boardCount, result.clearedCount, result.mayNeedGuessCount, result.boardsPerSec(), result.clicksPerSec(), result.p50, result.p99);
+	}
+}
+
 void Main()
 {
+# if defined(MINESWEEPER_BENCHMARK)
+
+	RunBenchmarks();
+
+# else
+
 	// 背景色をやや暗い灰色にする
 	Scene::SetBackground(ColorF{ 0.5 });
 
@@ -339,8 +332,11 @@ void Main()
 	// 設置する 💣 の個数
 	constexpr int32 BombCount = 30;
 
-	// 💣 の個数がマス目の 4 分の 1 以上の場合はコンパイルエラーにする
-	static_assert(BombCount < (GameSize.area() / 4));
+	// 盤面の生成方法
+	constexpr GeneratorMode Mode = GeneratorMode::NoGuess;
+
+	// 最初に開くマスとその周囲 (9 マス) 以外に 💣 を置ききれない場合はコンパイルエラーにする
+	static_assert(BombCount <= (GameSize.area() - 9));
 
 	// セルの大きさ
 	constexpr Size CellSize{ 40, 40 };
@@ -360,15 +356,50 @@ void Main()
 	// GameState に対応する顔絵文字
 	const std::array<Texture, 3> faceTextures = { Texture{ U"🙂"_emoji }, Texture{ U"😵"_emoji }, Texture{ U"😎"_emoji } };
 
-	// 盤面を作成する
-	Grid<int32> grid = MakeGame(GameSize, BombCount);
+	// 無限に広い盤面で遊ぶ
+	if constexpr (Mode == GeneratorMode::Infinite)
+	{
+		RunInfiniteGame(font, bombTexture, flagTexture, faceTextures, CellSize);
+		return;
+	}
 
-	// 各セルの状態を作成する
-	Grid<CellState> states = MakeStates(grid);
+	// 盤面のシード（NoGuess モードでは最初のクリックで使う）
+	uint64 seed = RandomUint64();
+
+	// 盤面を作成する（NoGuess モードでは最初のクリックまで 💣 のない盤面にしておく）
+	Board board = ((Mode == GeneratorMode::Classic) ? MakeGame(GameSize, BombCount, seed) : Board{ GameSize });
 
 	// ゲームの状態
 	GameState gameState = GameState::Game;
 
+	// 開かれていないマスの個数（クリア判定に使う）
+	int32 unopenedCount = GameSize.area();
+
+	// NoGuess モードで、推測なしで解ける盤面が見つからなかったか
+	bool mayNeedGuess = false;
+
+	// マスを開くときに使う作業用の配列
+	Array<Point> openQueue;
+
+	// リプレイのファイルパス
+	const FilePath ReplayPath = U"replay.msrp";
+
+	// 操作を記録するレコーダー
+	ReplayRecorder recorder;
+	recorder.begin(Mode, seed, GameSize, BombCount);
+
+	// 盤面を描くレンダラー
+	BoardRenderer boardRenderer{ GameSize, CellSize, ColorF{ 0.5 } };
+
+	// ヒントを求めるソルバー
+	Solver solver{ GameSize };
+
+	// 表示中のヒント
+	Optional<Solver::Hint> hint;
+
+	// 盤面をクリアするのに必要な最小のクリック数 (3BV)。💣 の配置が決まるまでは none
+	Optional<int32> minimumClicks;
+
 	// 顔ボタンの領域
 	const Rect faceButton{ Arg::center(Scene::Width() / 2, 40), 72 };
 
@@ -383,15 +414,70 @@ void Main()
 			// ゲームが進行中なら盤面を更新
 			if (gameState == GameState::Game)
 			{
-				UpdateGame(gameState, grid, states, BombCount, GamePos, CellSize);
+				UpdateGame(gameState, board, Mode, BombCount, seed, unopenedCount, mayNeedGuess, openQueue, recorder, GamePos, CellSize);
+
+				// [H] キーでヒントを求める
+				if (KeyH.down())
+				{
+					hint = solver.findHint(board, BombCount);
+				}
+			}
+
+			// 💣 の配置が決まったら 3BV を求める（NoGuess モードでは最初のクリックで決まる）
+			if ((not minimumClicks) && ((Mode == GeneratorMode::Classic) || (unopenedCount != GameSize.area())))
+			{
+				minimumClicks = CountMinimumClicks(board);
+			}
+
+			// [S] キーでこれまでの操作をリプレイとして保存する
+			if (KeyS.down())
+			{
+				recorder.replay().save(ReplayPath);
+			}
+
+			// [R] キーで保存したリプレイをウィンドウなしで待ち時間なしに繰り返し再生し、ゲームの処理の速さを表示する
+			if (KeyR.down())
+			{
+				if (const auto replay = Replay::Load(ReplayPath))
+				{
+					Board replayBoard;
+					Array<Point> replayQueue;
+					ReplayResult result;
+					int32 repetitions = 0;
+
+					const Stopwatch stopwatch{ StartImmediately::Yes };
+
+					do
+					{
+						result = PlayReplay(*replay, replayBoard, replayQueue);
+						++repetitions;
+					} while (stopwatch.sF() < 0.5);
+
+					const double sec = stopwatch.sF();
+					constexpr StringView ResultNames[3] = { U"Game", U"Failed", U"Cleared" };
+
+					Print << U"{}: {} actions, {:.0f} replays/s, {:.0f} actions/s"_fmt(ResultNames[FromEnum(result.gameState)],
+						result.actionCount, (repetitions / sec), (repetitions * result.actionCount / sec));
+				}
+			}
+
+			// 盤面が操作されたらヒントを消す
+			if (MouseL.down() || MouseR.down())
+			{
+				hint.reset();
 			}
 
 			// 顔ボタンが押されたら状態を初期化
 			if (faceButton.leftClicked())
 			{
-				grid = MakeGame(GameSize, BombCount);
-				states = MakeStates(grid);
+				seed = RandomUint64();
+				board = ((Mode == GeneratorMode::Classic) ? MakeGame(GameSize, BombCount, seed) : Board{ GameSize });
+				unopenedCount = GameSize.area();
+				mayNeedGuess = false;
 				gameState = GameState::Game;
+				solver = Solver{ GameSize };
+				minimumClicks.reset();
+				recorder.begin(Mode, seed, GameSize, BombCount);
 			}
 		}
 
@@ -402,7 +488,14 @@ void Main()
 		////////////////////////////////
 		{
 			// 盤面を描く
-			DrawGame(grid, states, font, bombTexture, flagTexture, GamePos, CellSize);
+			DrawGame(boardRenderer, board, font, bombTexture, flagTexture, GamePos);
+
+			// ヒントのマスを囲む（安全なら緑、推測が必要ならオレンジ）
+			if (hint)
+			{
+				const Rect cell{ (GamePos + (CellSize * hint->pos)), CellSize };
+				cell.drawFrame(4, ((hint->mineProbability == 0.0) ? ColorF{ 0.0, 0.8, 0.2 } : ColorF{ 1.0, 0.5, 0.0 }));
+			}
 
 			// UI エリアの背景を描く
 			Rect{ Scene::Width(), 80 }.draw(ColorF{ 0.75 });
@@ -412,7 +505,27 @@ void Main()
 
 				// 顔を描く
 				faceTextures[FromEnum(gameState)].resized(60).drawAt(faceButton.center());
+
+				// ヒントのマスが 💣 である確率を描く
+				if (hint)
+				{
+					font(U"{:.1f}%"_fmt(hint->mineProbability * 100)).draw(24, Arg::leftCenter(20, 40), ColorF{ 0.1 });
+				}
+
+				// 3BV を描く
+				if (minimumClicks)
+				{
+					font(U"3BV: {}"_fmt(*minimumClicks)).draw(24, Arg::rightCenter((Scene::Width() - 20), 40), ColorF{ 0.1 });
+				}
+
+				// 推測なしで解ける盤面が見つからなかったことを知らせる
+				if (mayNeedGuess)
+				{
+					font(U"推測が必要な場合があります").draw(16, Arg::rightCenter((Scene::Width() - 20), 66), ColorF{ 0.6, 0.1, 0.0 });
+				}
 			}
 		}
 	}
+
+# endif
 }
@@ -0,0 +1,289 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Game.hpp"
+
+/// @brief リプレイに記録する 1 回の操作
+struct ReplayEvent
+{
+	/// @brief 記録を始めてからのフレーム数
+	int32 frame = 0;
+
+	/// @brief 操作したマス
+	Point pos{ 0, 0 };
+
+	/// @brief 操作
+	Action action = Action::Open;
+};
+
+/// @brief 1 回のゲームのリプレイ
+/// @remark 盤面はシードから作り直せるので、盤面の生成方法・シード・盤面の大きさ・💣 の個数と、盤面を変えた操作の列だけを持ちます。
+/// バイナリ形式は、マジックナンバー "MSRP", バージョン (1 バイト), 生成方法 (1 バイト), シード (8 バイト, リトルエンディアン) の後に、
+/// 幅・高さ・💣 の個数・操作の個数と、操作ごとに「前の操作からのフレーム数」「(マスのインデックス << 1) | 操作」を可変長整数 (LEB128) で並べたものです。
+struct Replay
+{
+	/// @brief バイナリ形式のバージョン
+	/// @remark NoGuess モードの候補の盤面のシードの求め方を変えたので 2 にしました（バージョン 1 のリプレイは同じ盤面を再現できないので読み込みません）。
+	static constexpr uint8 Version = 2;
+
+	/// @brief 盤面の生成方法
+	GeneratorMode generatorMode = GeneratorMode::Classic;
+
+	/// @brief 盤面のシード
+	uint64 seed = 0;
+
+	/// @brief 盤面のマス目の数
+	Size size{ 0, 0 };
+
+	/// @brief 💣 の個数
+	int32 mineCount = 0;
+
+	/// @brief 操作の列
+	Array<ReplayEvent> events;
+
+	/// @brief バイナリ形式に変換します。
+	/// @return バイナリ形式のリプレイ
+	[[nodiscard]]
+	Array<uint8> encode() const
+	{
+		Array<uint8> data = { 'M', 'S', 'R', 'P', Version, static_cast<uint8>(generatorMode) };
+
+		for (int32 i = 0; i < 8; ++i)
+		{
+			data << static_cast<uint8>(seed >> (i * 8));
+		}
+
+		WriteVarint(data, size.x);
+		WriteVarint(data, size.y);
+		WriteVarint(data, mineCount);
+		WriteVarint(data, events.size());
+
+		int32 previousFrame = 0;
+
+		for (const auto& event : events)
+		{
+			WriteVarint(data, (event.frame - previousFrame));
+			WriteVarint(data, ((static_cast<uint64>(event.pos.y) * size.x + event.pos.x) << 1) | static_cast<uint64>(event.action));
+			previousFrame = event.frame;
+		}
+
+		return data;
+	}
+
+	/// @brief バイナリ形式から読み込みます。
+	/// @param data バイナリ形式のリプレイ
+	/// @return 読み込んだリプレイ。形式が正しくない場合は none
+	[[nodiscard]]
+	static Optional<Replay> Decode(const Array<uint8>& data)
+	{
+		constexpr size_t HeaderSize = 14;
+
+		if ((data.size() < HeaderSize)
+			|| (data[0] != 'M') || (data[1] != 'S') || (data[2] != 'R') || (data[3] != 'P')
+			|| (data[4] != Version) || (FromEnum(GeneratorMode::Infinite) <= data[5]))
+		{
+			return none;
+		}
+
+		Replay replay;
+		replay.generatorMode = ToEnum<GeneratorMode>(data[5]);
+
+		for (int32 i = 0; i < 8; ++i)
+		{
+			replay.seed |= (static_cast<uint64>(data[6 + i]) << (i * 8));
+		}
+
+		size_t offset = HeaderSize;
+		uint64 width, height, mineCount, eventCount;
+
+		if ((not ReadVarint(data, offset, width)) || (not ReadVarint(data, offset, height))
+			|| (not ReadVarint(data, offset, mineCount)) || (not ReadVarint(data, offset, eventCount))
+			|| (width == 0) || (height == 0) || ((Largest<int32> / width) < height)
+			|| (Largest<int32> < mineCount) || ((width * height) < (mineCount + 9))
+			|| (((data.size() - offset) / 2) < eventCount))
+		{
+			// 💣 は最初に開くマスとその周囲 (9 マス) 以外に置ききれなければならず、1 つの操作は少なくとも 2 バイトある
+			return none;
+		}
+
+		replay.size = Size{ static_cast<int32>(width), static_cast<int32>(height) };
+		replay.mineCount = static_cast<int32>(mineCount);
+		replay.events.reserve(eventCount);
+
+		uint64 frame = 0;
+
+		for (uint64 i = 0; i < eventCount; ++i)
+		{
+			uint64 frameDelta, cell;
+
+			if ((not ReadVarint(data, offset, frameDelta)) || (not ReadVarint(data, offset, cell))
+				|| ((width * height) <= (cell >> 1)) || (Largest<int32> < (frame += frameDelta)))
+			{
+				return none;
+			}
+
+			replay.events << ReplayEvent{ static_cast<int32>(frame),
+				Point{ static_cast<int32>((cell >> 1) % width), static_cast<int32>((cell >> 1) / width) },
+				static_cast<Action>(cell & 1) };
+		}
+
+		return replay;
+	}
+
+	/// @brief ファイルに保存します。
+	/// @param path ファイルパス
+	/// @return 保存できた場合 true, それ以外の場合は false
+	bool save(const FilePathView path) const
+	{
+		const Array<uint8> data = encode();
+		BinaryWriter writer{ path };
+		return (writer && (writer.write(data.data(), data.size()) == static_cast<int64>(data.size())));
+	}
+
+	/// @brief ファイルから読み込みます。
+	/// @param path ファイルパス
+	/// @return 読み込んだリプレイ。読み込めなかった場合は none
+	[[nodiscard]]
+	static Optional<Replay> Load(const FilePathView path)
+	{
+		BinaryReader reader{ path };
+
+		if (not reader)
+		{
+			return none;
+		}
+
+		Array<uint8> data(static_cast<size_t>(reader.size()));
+
+		if (reader.read(data.data(), data.size()) != static_cast<int64>(data.size()))
+		{
+			return none;
+		}
+
+		return Decode(data);
+	}
+
+private:
+
+	// 可変長整数 (LEB128) を書き込む
+	static void WriteVarint(Array<uint8>& data, uint64 value)
+	{
+		while (0x80 <= value)
+		{
+			data << static_cast<uint8>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+
+		data << static_cast<uint8>(value);
+	}
+
+	// 可変長整数 (LEB128) を読み込む。データが途中で終わっている場合や 64 ビットに収まらない場合は false を返す
+	static bool ReadVarint(const Array<uint8>& data, size_t& offset, uint64& value)
+	{
+		value = 0;
+
+		for (int32 shift = 0; shift < 64; shift += 7)
+		{
+			if (data.size() <= offset)
+			{
+				return false;
+			}
+
+			const uint8 byte = data[offset++];
+
+			// 10 バイト目は最下位ビットしか 64 ビットに収まらない
+			if ((shift == 63) && ((byte & 0x7E) != 0))
+			{
+				return false;
+			}
+
+			value |= (static_cast<uint64>(byte & 0x7F) << shift);
+
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+};
+
+/// @brief プレイヤーの操作をリプレイに記録するクラス
+class ReplayRecorder
+{
+public:
+
+	/// @brief 新しいゲームの記録を始めます。
+	/// @param generatorMode 盤面の生成方法
+	/// @param seed 盤面のシード
+	/// @param size 盤面のマス目の数
+	/// @param mineCount 💣 の個数
+	void begin(GeneratorMode generatorMode, uint64 seed, const Size& size, int32 mineCount)
+	{
+		m_replay = Replay{ generatorMode, seed, size, mineCount, {} };
+		m_startFrame = Scene::FrameCount();
+	}
+
+	/// @brief 盤面を変えた操作を記録します。
+	/// @param pos 操作したマス
+	/// @param action 操作
+	void record(const Point& pos, Action action)
+	{
+		m_replay.events << ReplayEvent{ static_cast<int32>(Scene::FrameCount() - m_startFrame), pos, action };
+	}
+
+	/// @brief 記録したリプレイを返します。
+	[[nodiscard]]
+	const Replay& replay() const noexcept
+	{
+		return m_replay;
+	}
+
+private:
+
+	Replay m_replay;
+
+	int32 m_startFrame = 0;
+};
+
+/// @brief リプレイを再生した結果
+struct ReplayResult
+{
+	/// @brief 再生し終えたときのゲームの状態
+	GameState gameState = GameState::Game;
+
+	/// @brief 再生し終えたときの開かれていないマスの個数
+	int32 unopenedCount = 0;
+
+	/// @brief NoGuess モードで、推測なしで解ける盤面が見つからなかったか
+	bool mayNeedGuess = false;
+
+	/// @brief 再生した操作の個数（ゲームが終わった後の操作は再生しません）
+	size_t actionCount = 0;
+};
+
+/// @brief リプレイをウィンドウなしで、待ち時間なしに再生します。
+/// @param replay リプレイ
+/// @param board 盤面（再生し終えた盤面が書き込まれます）
+/// @param openQueue マスを開くときに使う作業用の配列
+/// @return 再生した結果
+/// @remark 盤面の生成から、マスを開く処理・クリア判定までのゲームの処理だけを実行するので、それらの処理のスループットの計測にも使えます。
+inline ReplayResult PlayReplay(const Replay& replay, Board& board, Array<Point>& openQueue)
+{
+	board = ((replay.generatorMode == GeneratorMode::Classic) ? MakeGame(replay.size, replay.mineCount, replay.seed) : Board{ replay.size });
+
+	ReplayResult result{ .unopenedCount = replay.size.area() };
+
+	for (const auto& event : replay.events)
+	{
+		if (result.gameState != GameState::Game)
+		{
+			break;
+		}
+
+		ApplyAction(result.gameState, board, replay.generatorMode, replay.mineCount, replay.seed, result.unopenedCount, result.mayNeedGuess, openQueue, event.pos, event.action);
+		++result.actionCount;
+	}
+
+	return result;
+}
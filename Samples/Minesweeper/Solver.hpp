@@ -0,0 +1,806 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Board.hpp"
+
+/// @brief 開かれたマスの数字から、安全なマスと 💣 のマスを推論するソルバー
+/// @remark 💣 の配置は参照せず、プレイヤーと同じ情報（開かれたマスの数字と、盤面全体の 💣 の個数）だけを使います。
+class Solver
+{
+public:
+
+	/// @brief マスについて推論できたこと
+	enum class Deduction : uint8
+	{
+		Unknown,	// わからない
+		Safe,		// 安全
+		Mine,		// 💣
+	};
+
+	/// @brief 次に開くマスのヒント
+	struct Hint
+	{
+		/// @brief 開くマス
+		Point pos;
+
+		/// @brief そのマスが 💣 である確率（安全だと推論できた場合は 0）
+		double mineProbability = 0.0;
+	};
+
+	Solver() = default;
+
+	/// @brief 何も推論していない状態のソルバーを作成します。
+	/// @param size 盤面のマス目の数
+	explicit Solver(const Size& size)
+		: m_deductions(size) {}
+
+	/// @brief 推論できることがなくなるまで推論を進めます。
+	/// @param board 盤面
+	/// @param totalMines 盤面全体の 💣 の個数
+	/// @return 新たに推論できたマスがあれば true, それ以外の場合は false
+	/// @remark 次の順に、より単純なルールで推論できなくなったら次のルールを試します。
+	/// 1. 1 つの数字マスだけで決まるもの（残りの 💣 が 0 個、または残りのマスがすべて 💣）
+	/// 2. 距離 2 以内の 2 つの数字マスの組で決まるもの（一方の未確定マスが他方に含まれる場合など）
+	/// 3. 盤面全体の 💣 の残り個数で決まるもの
+	bool deduce(const Board& board, int32 totalMines)
+	{
+		m_safeCells.clear();
+
+		bool progressed = false;
+
+		for (;;)
+		{
+			collectFrontier(board);
+
+			if (applySingleRules(board)
+				|| applyPairRules(board)
+				|| applyGlobalRule(board, totalMines))
+			{
+				progressed = true;
+				continue;
+			}
+
+			return progressed;
+		}
+	}
+
+	/// @brief 未確定の各マスが 💣 である確率を計算します。
+	/// @param board 盤面
+	/// @param totalMines 盤面全体の 💣 の個数
+	/// @return 計算できた場合 true, 列挙する局面数が上限を超えた場合や、開かれたマスの数字に矛盾がある場合は false
+	/// @remark 数字マスに隣接する未確定のマスを、数字マスを介してつながる成分に分け、成分ごとに 💣 の配置をすべて列挙します。
+	/// 成分ごとの「💣 の個数ごとの配置の数」を畳み込み、数字マスに隣接しない残りのマスへの 💣 の配置の数（二項係数）で重み付けして、厳密な確率を求めます。
+	bool computeProbabilities(const Board& board, int32 totalMines)
+	{
+		const Size size = board.size();
+
+		m_probabilities = Grid<double>(size, 0.0);
+
+		collectFrontier(board);
+
+		// 変数（数字マスに隣接する未確定のマス）と、数字マスごとの制約を作る
+		m_variables.clear();
+		m_variableIndices = Grid<int32>(size, -1);
+		m_constraints.clear();
+
+		for (const auto& pos : m_frontier)
+		{
+			Constraint constraint{ .mines = remainingMines(board, pos) };
+
+			for (const auto& offset : Offsets)
+			{
+				if (const Point neighbor = (pos + offset);
+					isUndetermined(board, neighbor))
+				{
+					int32& index = m_variableIndices[neighbor];
+
+					if (index == -1)
+					{
+						index = static_cast<int32>(m_variables.size());
+						m_variables << neighbor;
+					}
+
+					constraint.variables[constraint.variableCount++] = index;
+				}
+			}
+
+			m_constraints << constraint;
+		}
+
+		const int32 variableCount = static_cast<int32>(m_variables.size());
+
+		// 変数ごとに、その変数を含む制約
+		m_constraintsOfVariable.assign(variableCount, Array<int32>{});
+
+		for (int32 i = 0; i < static_cast<int32>(m_constraints.size()); ++i)
+		{
+			for (int32 k = 0; k < m_constraints[i].variableCount; ++k)
+			{
+				m_constraintsOfVariable[m_constraints[i].variables[k]] << i;
+			}
+		}
+
+		// 成分ごとに、💣 の配置を列挙する
+		Array<Component> components;
+		{
+			Array<bool> visited(variableCount, false);
+
+			for (int32 i = 0; i < variableCount; ++i)
+			{
+				if (visited[i])
+				{
+					continue;
+				}
+
+				// 制約を介してつながる変数を幅優先探索で集める（隣り合う変数が続くので、列挙の枝刈りが効きやすい）
+				Component component;
+				component.variables << i;
+				visited[i] = true;
+
+				for (size_t k = 0; k < component.variables.size(); ++k)
+				{
+					for (const int32 c : m_constraintsOfVariable[component.variables[k]])
+					{
+						for (int32 v = 0; v < m_constraints[c].variableCount; ++v)
+						{
+							if (const int32 next = m_constraints[c].variables[v];
+								not visited[next])
+							{
+								visited[next] = true;
+								component.variables << next;
+							}
+						}
+					}
+				}
+
+				if (not enumerate(component))
+				{
+					return false;
+				}
+
+				components << std::move(component);
+			}
+		}
+
+		// 数字マスに隣接しない未確定のマスの個数
+		int32 interiorCount = 0;
+
+		for (int32 y = 0; y < size.y; ++y)
+		{
+			for (int32 x = 0; x < size.x; ++x)
+			{
+				if (const Point pos{ x, y };
+					isUndetermined(board, pos) && (m_variableIndices[pos] == -1))
+				{
+					++interiorCount;
+				}
+			}
+		}
+
+		// まだ推論できていない 💣 の個数
+		const int32 mines = (totalMines - m_deducedMineCount);
+
+		// prefixes[i]: 成分 0, 1, ..., i - 1 の配置の数の畳み込み, suffixes[i]: 成分 i, i + 1, ... の配置の数の畳み込み
+		Array<Array<double>> prefixes{ Array<double>{ 1.0 } };
+		Array<Array<double>> suffixes(components.size() + 1, Array<double>{ 1.0 });
+
+		for (const auto& component : components)
+		{
+			prefixes << Convolve(prefixes.back(), component.counts);
+		}
+
+		for (size_t i = components.size(); 0 < i; --i)
+		{
+			suffixes[i - 1] = Convolve(suffixes[i], components[i - 1].counts);
+		}
+
+		// 数字マスに隣接するマスに t 個の 💣 があるときの、残りのマスへの配置の数（最大値で割って桁あふれを防ぐ）
+		const Array<double>& all = prefixes.back();
+		Array<double> interiorWeights(all.size(), 0.0);
+		{
+			double maxLog = -Math::Inf;
+
+			for (int32 t = 0; t < static_cast<int32>(all.size()); ++t)
+			{
+				if ((0 < all[t]) && (0 <= (mines - t)) && ((mines - t) <= interiorCount))
+				{
+					maxLog = Max(maxLog, logBinomial(interiorCount, (mines - t)));
+				}
+			}
+
+			for (int32 t = 0; t < static_cast<int32>(all.size()); ++t)
+			{
+				if ((0 < all[t]) && (0 <= (mines - t)) && ((mines - t) <= interiorCount))
+				{
+					interiorWeights[t] = std::exp(logBinomial(interiorCount, (mines - t)) - maxLog);
+				}
+			}
+		}
+
+		// すべての配置の数（の定数倍）
+		double total = 0.0;
+		double interiorMines = 0.0;
+
+		for (int32 t = 0; t < static_cast<int32>(all.size()); ++t)
+		{
+			total += (all[t] * interiorWeights[t]);
+
+			if (interiorCount)
+			{
+				interiorMines += (all[t] * interiorWeights[t] * (mines - t) / interiorCount);
+			}
+		}
+
+		if (total <= 0.0) // 開かれたマスの数字に矛盾がある
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < components.size(); ++i)
+		{
+			const Component& component = components[i];
+			const Array<double> others = Convolve(prefixes[i], suffixes[i + 1]);
+			const size_t n = component.variables.size();
+
+			for (size_t k = 0; k < component.counts.size(); ++k)
+			{
+				// この成分に k 個の 💣 があるときの、ほかの成分と残りのマスへの配置の数
+				double weight = 0.0;
+
+				for (size_t s = 0; s < others.size(); ++s)
+				{
+					weight += (others[s] * interiorWeights[k + s]);
+				}
+
+				for (size_t v = 0; v < n; ++v)
+				{
+					m_probabilities[m_variables[component.variables[v]]] += (component.mineCounts[k * n + v] * weight / total);
+				}
+			}
+		}
+
+		for (int32 y = 0; y < size.y; ++y)
+		{
+			for (int32 x = 0; x < size.x; ++x)
+			{
+				const Point pos{ x, y };
+
+				if (m_deductions[pos] == Deduction::Mine)
+				{
+					m_probabilities[pos] = 1.0;
+				}
+				else if (isUndetermined(board, pos) && (m_variableIndices[pos] == -1))
+				{
+					m_probabilities[pos] = (interiorMines / total);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/// @brief 次に開くマスのヒントを返します。
+	/// @param board 盤面
+	/// @param totalMines 盤面全体の 💣 の個数
+	/// @return 安全だと推論できたマスがあればそのマス、なければ 💣 である確率が最も低いマス。開くマスが無い場合は none
+	[[nodiscard]]
+	Optional<Hint> findHint(const Board& board, int32 totalMines)
+	{
+		deduce(board, totalMines);
+
+		// 安全だと推論できた、まだ開かれていないマス
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				if (const Point pos{ x, y };
+					(m_deductions[pos] == Deduction::Safe) && (not board[pos].isOpened()))
+				{
+					return Hint{ pos, 0.0 };
+				}
+			}
+		}
+
+		const bool computed = computeProbabilities(board, totalMines);
+
+		Optional<Hint> result;
+
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				const Point pos{ x, y };
+
+				if (not isUndetermined(board, pos))
+				{
+					continue;
+				}
+
+				// 確率を計算できなかった場合は、最初に見つかった未確定のマスを選ぶ
+				if (not computed)
+				{
+					return Hint{ pos, 1.0 };
+				}
+
+				if ((not result) || (m_probabilities[pos] < result->mineProbability))
+				{
+					result = Hint{ pos, m_probabilities[pos] };
+				}
+			}
+		}
+
+		return result;
+	}
+
+	/// @brief 直前の computeProbabilities() で計算した、指定したマスが 💣 である確率を返します。
+	[[nodiscard]]
+	double probability(const Point& pos) const
+	{
+		return m_probabilities[pos];
+	}
+
+	/// @brief 指定したマスについて推論できたことを返します。
+	[[nodiscard]]
+	Deduction operator [](const Point& pos) const
+	{
+		return m_deductions[pos];
+	}
+
+	/// @brief 直前の deduce() で新たに安全だと推論できたマスの一覧を返します。
+	[[nodiscard]]
+	const Array<Point>& safeCells() const noexcept
+	{
+		return m_safeCells;
+	}
+
+	/// @brief 💣 だと推論できたマスの個数を返します。
+	[[nodiscard]]
+	int32 deducedMineCount() const noexcept
+	{
+		return m_deducedMineCount;
+	}
+
+private:
+
+	// 確率の計算で、1 つの成分について列挙する局面数の上限
+	static constexpr int64 MaxEnumerationNodes = 1'000'000;
+
+	// 数字マスの周囲の 💣 の個数に関する制約
+	struct Constraint
+	{
+		// 数字マスに隣接する変数のインデックス
+		std::array<int32, 8> variables{};
+
+		int32 variableCount = 0;
+
+		// 変数のうち 💣 であるものの個数
+		int32 mines = 0;
+	};
+
+	// 制約を介してつながる変数の集まり
+	struct Component
+	{
+		// 変数のインデックス
+		Array<int32> variables;
+
+		// [k]: 成分内に k 個の 💣 がある配置の数
+		Array<double> counts;
+
+		// [k * variables.size() + v]: 成分内に k 個の 💣 がある配置のうち、v 番目の変数が 💣 であるものの数
+		Array<double> mineCounts;
+	};
+
+	// 各マスについて推論できたこと
+	Grid<Deduction> m_deductions;
+
+	// 直前の deduce() で新たに安全だと推論できたマス
+	Array<Point> m_safeCells;
+
+	// 💣 だと推論できたマスの個数
+	int32 m_deducedMineCount = 0;
+
+	// 未確定のマスに隣接する、開かれた数字マス
+	Array<Point> m_frontier;
+
+	// 各マスが 💣 である確率
+	Grid<double> m_probabilities;
+
+	// 変数（数字マスに隣接する未確定のマス）
+	Array<Point> m_variables;
+
+	// 各マスの変数のインデックス（変数でなければ -1）
+	Grid<int32> m_variableIndices;
+
+	// 数字マスごとの制約
+	Array<Constraint> m_constraints;
+
+	// 変数ごとに、その変数を含む制約のインデックス
+	Array<Array<int32>> m_constraintsOfVariable;
+
+	// 列挙中の状態: 制約ごとの 💣 の個数と、値の決まっていない変数の個数、変数ごとの値
+	Array<int32> m_assignedMines;
+
+	Array<int32> m_unassignedCounts;
+
+	Array<uint8> m_values;
+
+	// 列挙した局面数
+	int64 m_enumerationNodes = 0;
+
+	// log(n!) のメモ
+	Array<double> m_logFactorials{ 0.0 };
+
+	// log(n choose k) を返す
+	[[nodiscard]]
+	double logBinomial(int32 n, int32 k)
+	{
+		while (static_cast<int32>(m_logFactorials.size()) <= n)
+		{
+			m_logFactorials << (m_logFactorials.back() + std::log(static_cast<double>(m_logFactorials.size())));
+		}
+
+		return (m_logFactorials[n] - m_logFactorials[k] - m_logFactorials[n - k]);
+	}
+
+	// 2 つの数列を畳み込む
+	[[nodiscard]]
+	static Array<double> Convolve(const Array<double>& a, const Array<double>& b)
+	{
+		Array<double> result((a.size() + b.size() - 1), 0.0);
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			for (size_t k = 0; k < b.size(); ++k)
+			{
+				result[i + k] += (a[i] * b[k]);
+			}
+		}
+
+		return result;
+	}
+
+	// 成分内の 💣 の配置をすべて列挙する。列挙する局面数が上限を超えた場合は false を返す
+	bool enumerate(Component& component)
+	{
+		const size_t n = component.variables.size();
+
+		component.counts.assign((n + 1), 0.0);
+		component.mineCounts.assign(((n + 1) * n), 0.0);
+
+		m_assignedMines.assign(m_constraints.size(), 0);
+		m_unassignedCounts.resize(m_constraints.size());
+
+		for (size_t i = 0; i < m_constraints.size(); ++i)
+		{
+			m_unassignedCounts[i] = m_constraints[i].variableCount;
+		}
+
+		m_values.assign(m_variables.size(), 0);
+		m_enumerationNodes = 0;
+
+		return enumerate(component, 0, 0);
+	}
+
+	// depth 番目以降の変数の値を決めて列挙する
+	bool enumerate(Component& component, size_t depth, int32 mines)
+	{
+		if (MaxEnumerationNodes < ++m_enumerationNodes)
+		{
+			return false;
+		}
+
+		const size_t n = component.variables.size();
+
+		if (depth == n) // すべての制約を満たす配置が 1 つ見つかった
+		{
+			component.counts[mines] += 1.0;
+
+			for (size_t v = 0; v < n; ++v)
+			{
+				if (m_values[component.variables[v]])
+				{
+					component.mineCounts[mines * n + v] += 1.0;
+				}
+			}
+
+			return true;
+		}
+
+		const int32 variable = component.variables[depth];
+		const auto& constraints = m_constraintsOfVariable[variable];
+
+		for (uint8 value = 0; value <= 1; ++value)
+		{
+			// この変数を含むすべての制約が、まだ満たせる見込みがあるか
+			const bool feasible = std::all_of(constraints.begin(), constraints.end(), [&](int32 c)
+				{
+					const int32 assigned = (m_assignedMines[c] + value);
+					return ((assigned <= m_constraints[c].mines)
+						&& (m_constraints[c].mines <= (assigned + m_unassignedCounts[c] - 1)));
+				});
+
+			if (not feasible)
+			{
+				continue;
+			}
+
+			for (const int32 c : constraints)
+			{
+				m_assignedMines[c] += value;
+				--m_unassignedCounts[c];
+			}
+
+			m_values[variable] = value;
+
+			const bool completed = enumerate(component, (depth + 1), (mines + value));
+
+			for (const int32 c : constraints)
+			{
+				m_assignedMines[c] -= value;
+				++m_unassignedCounts[c];
+			}
+
+			if (not completed)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// 開かれておらず、推論もできていないマスであるか
+	[[nodiscard]]
+	bool isUndetermined(const Board& board, const Point& pos) const
+	{
+		return (board.inBounds(pos) && (not board[pos].isOpened()) && (m_deductions[pos] == Deduction::Unknown));
+	}
+
+	// center の周囲の未確定のマスを、origin を中心とする 7x7 マスの範囲のビットマスクで返す
+	[[nodiscard]]
+	uint64 undeterminedMask(const Board& board, const Point& center, const Point& origin) const
+	{
+		uint64 mask = 0;
+
+		for (const auto& offset : Offsets)
+		{
+			if (const Point pos = (center + offset);
+				isUndetermined(board, pos))
+			{
+				const Point d = (pos - origin);
+				mask |= (1ULL << ((d.y + 3) * 7 + (d.x + 3)));
+			}
+		}
+
+		return mask;
+	}
+
+	// 数字マス center の周囲にある、まだ推論できていない 💣 の個数を返す
+	[[nodiscard]]
+	int32 remainingMines(const Board& board, const Point& center) const
+	{
+		int32 count = board.number(center);
+
+		for (const auto& offset : Offsets)
+		{
+			if (const Point pos = (center + offset);
+				board.inBounds(pos) && (m_deductions[pos] == Deduction::Mine))
+			{
+				--count;
+			}
+		}
+
+		return count;
+	}
+
+	// 推論の結果を記録する
+	void mark(const Point& pos, Deduction deduction)
+	{
+		if (m_deductions[pos] != Deduction::Unknown)
+		{
+			return;
+		}
+
+		m_deductions[pos] = deduction;
+
+		if (deduction == Deduction::Safe)
+		{
+			m_safeCells << pos;
+		}
+		else
+		{
+			++m_deducedMineCount;
+		}
+	}
+
+	// origin を中心とする 7x7 マスの範囲のビットマスクが表すマスに、推論の結果を記録する
+	void mark(const Point& origin, uint64 mask, Deduction deduction)
+	{
+		for (; mask; mask &= (mask - 1))
+		{
+			const int32 bit = std::countr_zero(mask);
+			mark((origin + Point{ (bit % 7 - 3), (bit / 7 - 3) }), deduction);
+		}
+	}
+
+	// 未確定のマスに隣接する、開かれた数字マスを集める
+	void collectFrontier(const Board& board)
+	{
+		m_frontier.clear();
+
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				const Point pos{ x, y };
+
+				if (const PackedCell cell = board[pos];
+					cell.isOpened() && (not cell.isMine()) && (0 < cell.adjacentMines())
+					&& undeterminedMask(board, pos, pos))
+				{
+					m_frontier << pos;
+				}
+			}
+		}
+	}
+
+	// 1 つの数字マスだけで決まるものを推論する
+	bool applySingleRules(const Board& board)
+	{
+		bool progressed = false;
+
+		for (const auto& pos : m_frontier)
+		{
+			const uint64 mask = undeterminedMask(board, pos, pos);
+
+			if (mask == 0) // このループの中ですでに確定した
+			{
+				continue;
+			}
+
+			const int32 mines = remainingMines(board, pos);
+
+			if (mines == 0) // 残りはすべて安全
+			{
+				mark(pos, mask, Deduction::Safe);
+				progressed = true;
+			}
+			else if (mines == std::popcount(mask)) // 残りはすべて 💣
+			{
+				mark(pos, mask, Deduction::Mine);
+				progressed = true;
+			}
+		}
+
+		return progressed;
+	}
+
+	// 距離 2 以内の 2 つの数字マスの組で決まるものを推論する
+	bool applyPairRules(const Board& board)
+	{
+		for (const auto& a : m_frontier)
+		{
+			const uint64 maskA = undeterminedMask(board, a, a);
+
+			if (maskA == 0)
+			{
+				continue;
+			}
+
+			const int32 minesA = remainingMines(board, a);
+
+			for (int32 dy = -2; dy <= 2; ++dy)
+			{
+				for (int32 dx = -2; dx <= 2; ++dx)
+				{
+					const Point b = (a + Point{ dx, dy });
+
+					if (((dx == 0) && (dy == 0))
+						|| (not board.inBounds(b))
+						|| (not board[b].isOpened())
+						|| board[b].isMine())
+					{
+						continue;
+					}
+
+					const uint64 maskB = undeterminedMask(board, b, a);
+
+					// 共通する未確定のマスが無ければ、この組からわかることはない
+					if ((maskA & maskB) == 0)
+					{
+						continue;
+					}
+
+					const uint64 onlyA = (maskA & ~maskB);
+					const uint64 onlyB = (maskB & ~maskA);
+
+					// a だけに隣接するマスがすべて 💣 でないと a と b の数字の差を説明できない場合、
+					// a だけに隣接するマスはすべて 💣 で、b だけに隣接するマスはすべて安全
+					if ((onlyA | onlyB)
+						&& ((minesA - remainingMines(board, b)) == std::popcount(onlyA)))
+					{
+						mark(a, onlyA, Deduction::Mine);
+						mark(a, onlyB, Deduction::Safe);
+						return true;
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+	// 盤面全体の 💣 の残り個数で決まるものを推論する
+	bool applyGlobalRule(const Board& board, int32 totalMines)
+	{
+		const int32 mines = (totalMines - m_deducedMineCount);
+		int32 undetermined = 0;
+
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				if (isUndetermined(board, Point{ x, y }))
+				{
+					++undetermined;
+				}
+			}
+		}
+
+		if ((undetermined == 0)
+			|| ((mines != 0) && (mines != undetermined)))
+		{
+			return false;
+		}
+
+		// 残りの 💣 が 0 個なら残りはすべて安全、未確定のマスと同数なら残りはすべて 💣
+		const Deduction deduction = ((mines == 0) ? Deduction::Safe : Deduction::Mine);
+
+		for (int32 y = 0; y < board.height(); ++y)
+		{
+			for (int32 x = 0; x < board.width(); ++x)
+			{
+				if (isUndetermined(board, Point{ x, y }))
+				{
+					mark(Point{ x, y }, deduction);
+				}
+			}
+		}
+
+		return true;
+	}
+};
+
+/// @brief 指定したマスから開き始めて、推測なしで（推論だけで）すべての安全なマスを開けるかを調べます。
+/// @param board すべてのマスが開かれていない盤面
+/// @param start 最初に開くマス
+/// @param totalMines 盤面全体の 💣 の個数
+/// @return 推測なしですべての安全なマスを開ける場合 true, それ以外の場合は false
+inline bool IsSolvableWithoutGuessing(const Board& board, const Point& start, int32 totalMines)
+{
+	if (board[start].isMine())
+	{
+		return false;
+	}
+
+	// 盤面を複製して、ソルバーが推論したとおりに開いていく
+	Board simulated = board;
+	Solver solver{ board.size() };
+	Array<Point> queue;
+
+	int32 unopenedCount = (simulated.countUnopened() - OpenCells(simulated, start, queue));
+
+	while (unopenedCount != totalMines)
+	{
+		if (not solver.deduce(simulated, totalMines))
+		{
+			return false;
+		}
+
+		for (const auto& pos : solver.safeCells())
+		{
+			unopenedCount -= OpenCells(simulated, pos, queue);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,242 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Board.hpp"
+
+/// @brief チャンクに分けて必要な部分だけを持つ、無限に広い盤面
+/// @remark 各マスが 💣 かどうかはシードとマスの座標のハッシュだけで決まるので、チャンクは最初にアクセスされたときに、ほかのチャンクとは独立に生成できます。
+/// プレイヤーが触れていないチャンクはいつでも作り直せるので、遠くにあるものは evict() で捨てます。メモリ使用量は、探索した範囲と画面に映っている範囲に比例します。
+class World
+{
+public:
+
+	/// @brief チャンクの一辺のマスの数
+	static constexpr int32 ChunkSize = 32;
+
+	/// @brief 💣 の密度の下限
+	/// @remark 密度が低すぎると数字のないマスが無限につながり、マスを開く処理が終わらなくなります。
+	/// 数字のないマスになる確率 (1 - 密度)^9 が、8 近傍のサイトパーコレーションの閾値 (約 0.407) を下回るようにしています。
+	static constexpr double MinDensity = 0.1;
+
+	World() = default;
+
+	/// @brief 無限に広い盤面を作成します。
+	/// @param seed 💣 の配置を決めるシード
+	/// @param density 💣 の密度 (MinDensity 以上 1 未満)
+	/// @remark 原点 (0, 0) とその周囲 8 マスには 💣 を置きません。
+	World(uint64 seed, double density)
+		: m_seed{ seed }
+		, m_threshold{ static_cast<uint64>(Clamp(density, MinDensity, 0.99) * (1ULL << 53)) } {}
+
+	/// @brief 指定したマスが 💣 であるかを返します。
+	/// @remark チャンクを生成せずに、シードと座標から直接計算します。
+	[[nodiscard]]
+	bool isMine(const Point& pos) const noexcept
+	{
+		if ((Abs(pos.x) <= 1) && (Abs(pos.y) <= 1))
+		{
+			return false;
+		}
+
+		// SplitMix64 の最終段で座標とシードを混ぜる
+		uint64 h = (m_seed ^ (static_cast<uint64>(static_cast<uint32>(pos.x)) * 0x9E3779B97F4A7C15ULL) ^ (static_cast<uint64>(static_cast<uint32>(pos.y)) * 0xC2B2AE3D27D4EB4FULL));
+		h = ((h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL);
+		h = ((h ^ (h >> 27)) * 0x94D049BB133111EBULL);
+		h ^= (h >> 31);
+
+		return ((h >> 11) < m_threshold);
+	}
+
+	/// @brief 指定したマスの状態を返します。マスを含むチャンクがまだ無ければ生成します。
+	[[nodiscard]]
+	PackedCell operator [](const Point& pos)
+	{
+		return chunk(pos).cells[LocalIndex(pos)];
+	}
+
+	/// @brief 指定したマスを開きます。
+	/// @return 新たに開いた場合 true, すでに開かれていた場合 false
+	bool open(const Point& pos)
+	{
+		Chunk& c = chunk(pos);
+		PackedCell& cell = c.cells[LocalIndex(pos)];
+
+		if (cell.isOpened())
+		{
+			return false;
+		}
+
+		cell.bits |= PackedCell::OpenedBit;
+		c.touched = true;
+		return true;
+	}
+
+	/// @brief 旗の状態を反転します。
+	void toggleFlag(const Point& pos)
+	{
+		Chunk& c = chunk(pos);
+		c.cells[LocalIndex(pos)].bits ^= PackedCell::FlaggedBit;
+		c.touched = true;
+	}
+
+	/// @brief 爆発したフラグを立てます。
+	void explode(const Point& pos)
+	{
+		Chunk& c = chunk(pos);
+		c.cells[LocalIndex(pos)].bits |= PackedCell::ExplodedBit;
+		c.touched = true;
+	}
+
+	/// @brief プレイヤーが触れておらず、指定した範囲の外にあるチャンクを捨てます。
+	/// @param keepChunks 残すチャンクの範囲（チャンク座標）
+	/// @return 捨てたチャンクの個数
+	size_t evict(const Rect& keepChunks)
+	{
+		const size_t oldCount = m_chunks.size();
+
+		EraseNodes_if(m_chunks, [&](const auto& pair)
+			{
+				return ((not pair.second.touched) && (not keepChunks.intersects(pair.first)));
+			});
+
+		return (oldCount - m_chunks.size());
+	}
+
+	/// @brief 生成済みのチャンクの個数を返します。
+	[[nodiscard]]
+	size_t chunkCount() const noexcept
+	{
+		return m_chunks.size();
+	}
+
+	/// @brief マスを含むチャンクの座標を返します。
+	[[nodiscard]]
+	static constexpr Point ChunkCoord(const Point& pos) noexcept
+	{
+		// 負の座標でも切り捨てになるように、算術右シフトで割る
+		static_assert(std::has_single_bit(static_cast<uint32>(ChunkSize)));
+		constexpr int32 Shift = std::countr_zero(static_cast<uint32>(ChunkSize));
+		return{ (pos.x >> Shift), (pos.y >> Shift) };
+	}
+
+private:
+
+	struct Chunk
+	{
+		std::array<PackedCell, (ChunkSize * ChunkSize)> cells;
+
+		// プレイヤーが開いたり旗を立てたりしたか（触れたチャンクは作り直せないので捨てない）
+		bool touched = false;
+	};
+
+	uint64 m_seed = 0;
+
+	// (ハッシュ値の上位 53 ビット) がこれより小さいマスが 💣
+	uint64 m_threshold = 0;
+
+	// チャンク座標 → チャンク
+	HashTable<Point, Chunk> m_chunks;
+
+	// チャンク内でのマスのインデックスを返す
+	[[nodiscard]]
+	static constexpr size_t LocalIndex(const Point& pos) noexcept
+	{
+		return ((pos.y & (ChunkSize - 1)) * ChunkSize + (pos.x & (ChunkSize - 1)));
+	}
+
+	// マスを含むチャンクを返す。まだ無ければ生成する
+	Chunk& chunk(const Point& pos)
+	{
+		const Point coord = ChunkCoord(pos);
+
+		if (auto it = m_chunks.find(coord);
+			it != m_chunks.end())
+		{
+			return it->second;
+		}
+
+		return m_chunks.emplace(coord, generate(coord)).first->second;
+	}
+
+	// チャンクを生成する
+	[[nodiscard]]
+	Chunk generate(const Point& coord) const
+	{
+		constexpr int32 PaddedSize = (ChunkSize + 2);
+
+		const Point origin = (coord * ChunkSize);
+
+		// 周囲 1 マスの余白を含めた 💣 の配置（隣のチャンクのマスも座標から直接計算できる）
+		std::array<uint8, (PaddedSize * PaddedSize)> mines;
+
+		for (int32 y = 0; y < PaddedSize; ++y)
+		{
+			for (int32 x = 0; x < PaddedSize; ++x)
+			{
+				mines[y * PaddedSize + x] = isMine(origin + Point{ (x - 1), (y - 1) });
+			}
+		}
+
+		Chunk result;
+
+		for (int32 y = 0; y < ChunkSize; ++y)
+		{
+			for (int32 x = 0; x < ChunkSize; ++x)
+			{
+				const uint8* above = &mines[y * PaddedSize + x];
+				const uint8* center = (above + PaddedSize);
+				const uint8* below = (center + PaddedSize);
+
+				const uint8 count = static_cast<uint8>(above[0] + above[1] + above[2] + center[0] + center[2] + below[0] + below[1] + below[2]);
+
+				result.cells[y * ChunkSize + x].bits = static_cast<uint8>(count | (center[1] ? PackedCell::MineBit : 0));
+			}
+		}
+
+		return result;
+	}
+};
+
+/// @brief 指定したマスを開き、数字のないマスであれば、つながっている数字のないマスとその周囲をチャンクの境界をまたいで開きます。
+/// @param world 無限に広い盤面
+/// @param start 開くマス
+/// @param queue 作業用の配列
+/// @return 新たに開いたマスの個数
+inline int32 OpenCells(World& world, const Point& start, Array<Point>& queue)
+{
+	if (not world.open(start))
+	{
+		return 0;
+	}
+
+	int32 openedCount = 1;
+
+	if (world[start].number() != 0)
+	{
+		return openedCount;
+	}
+
+	queue.clear();
+	queue << start;
+
+	// キューに積まれたマスはすべて開かれた数字のないマス (0)。範囲の端は無いので範囲チェックは不要
+	for (size_t i = 0; i < queue.size(); ++i)
+	{
+		const Point pos = queue[i];
+
+		for (const auto& offset : Offsets)
+		{
+			if (const Point neighbor = (pos + offset);
+				world.open(neighbor))
+			{
+				++openedCount;
+
+				if (world[neighbor].number() == 0)
+				{
+					queue << neighbor;
+				}
+			}
+		}
+	}
+
+	return openedCount;
+}
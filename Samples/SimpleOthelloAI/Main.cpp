@@ -64,6 +64,99 @@ namespace OthelloAI
 		return results;
 	}
 
+	/// @brief 評価に使うマスの種類の数
+	constexpr int32 CellWeightKinds = 10;
+
+	/// @brief マスの種類ごとの重み
+	constexpr int32 CellWeightScores[CellWeightKinds] = { 2714, 147, 69, -18, -577, -186, -153, -379, -122, -169 };
+
+	/// @brief マスの種類ごとのビットボード上の配置
+	constexpr uint64 CellWeightMasks[CellWeightKinds] = { 0x8100000000000081ULL, 0x4281000000008142ULL, 0x2400810000810024ULL, 0x1800008181000018ULL, 0x0042000000004200ULL,
+		0x0024420000422400ULL, 0x0018004242001800ULL, 0x0000240000240000ULL, 0x0000182424180000ULL, 0x0000001818000000ULL };
+
+	/// @brief 縦横斜めの 8 方向の、ビットボード上での列の移動量（前半 4 方向はビットが増える方向、後半 4 方向はビットが減る方向）
+	constexpr int32 DirectionDX[8] = { 1, 0, -1, 1, -1, 0, 1, -1 };
+
+	/// @brief 縦横斜めの 8 方向の、ビットボード上での行の移動量
+	constexpr int32 DirectionDY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+	/// @brief 各マスから 8 方向それぞれに盤の端まで伸ばした直線（自身のマスは含まない）を計算します。
+	/// @return [ビットボード上のインデックス][方向] の直線のビットボード
+	[[nodiscard]]
+	constexpr std::array<std::array<uint64, 8>, 64> MakeRayMasks()
+	{
+		std::array<std::array<uint64, 8>, 64> results{};
+
+		for (int32 pos = 0; pos < 64; ++pos)
+		{
+			for (int32 dir = 0; dir < 8; ++dir)
+			{
+				const int32 dx = DirectionDX[dir];
+				const int32 dy = DirectionDY[dir];
+
+				for (int32 x = (pos % 8 + dx), y = (pos / 8 + dy);
+					(0 <= x) && (x < 8) && (0 <= y) && (y < 8); x += dx, y += dy)
+				{
+					results[pos][dir] |= (1ULL << (y * 8 + x));
+				}
+			}
+		}
+
+		return results;
+	}
+
+	/// @brief 各マスがどの種類のマスに属するかを計算します。
+	/// @return [ビットボード上のインデックス] のマスの種類
+	[[nodiscard]]
+	constexpr std::array<int32, 64> MakeCellPatterns()
+	{
+		std::array<int32, 64> results{};
+
+		for (int32 kind = 0; kind < CellWeightKinds; ++kind)
+		{
+			for (int32 pos = 0; pos < 64; ++pos)
+			{
+				if (CellWeightMasks[kind] & (1ULL << pos))
+				{
+					results[pos] = kind;
+				}
+			}
+		}
+
+		return results;
+	}
+
+	/// @brief ビットボードの 1 行（8 マス）の石の配置ごとに、重みの合計を計算します。
+	/// @return [行][その行の 8 ビット] の重みの合計
+	[[nodiscard]]
+	constexpr std::array<std::array<int32, 256>, 8> MakeRowWeightTables()
+	{
+		constexpr std::array<int32, 64> CellPatterns = MakeCellPatterns();
+		std::array<std::array<int32, 256>, 8> results{};
+
+		for (int32 row = 0; row < 8; ++row)
+		{
+			for (int32 bits = 0; bits < 256; ++bits)
+			{
+				for (int32 i = 0; i < 8; ++i)
+				{
+					if (bits & (1 << i))
+					{
+						results[row][bits] += CellWeightScores[CellPatterns[row * 8 + i]];
+					}
+				}
+			}
+		}
+
+		return results;
+	}
+
+	/// @brief [ビットボード上のインデックス][方向] の直線のビットボード
+	constexpr std::array<std::array<uint64, 8>, 64> RayMasks = MakeRayMasks();
+
+	/// @brief [行][その行の 8 ビット] の重みの合計
+	constexpr std::array<std::array<int32, 256>, 8> RowWeightTables = MakeRowWeightTables();
+
 	/// @brief 着手の情報
 	struct Move
 	{
@@ -128,15 +221,14 @@ namespace OthelloAI
 		/// @return 着手情報
 		Move makeMove(BitBoardIndex pos) const
 		{
-			constexpr int32 Shifts[8] = { 1, -1, 8, -8, 7, -7, 9, -9 };
-			constexpr uint64 Masks[4] = { 0x7E7E7E7E7E7E7E7EULL, 0x00FFFFFFFFFFFF00ULL, 0x007E7E7E7E7E7E00ULL, 0x007E7E7E7E7E7E00ULL };
-			const uint64 x = (1ULL << pos);
+			const auto& rays = RayMasks[pos];
 			Move move{ .pos = pos, .flip = 0ULL };
 
-			// 縦横斜めの8方向それぞれ別に計算する
-			for (int32 i = 0; i < 8; ++i)
+			// 縦横斜めの8方向それぞれ別に、事前計算した直線を使って計算する
+			for (int32 i = 0; i < 4; ++i)
 			{
-				move.flip |= GetFlipPart(m_player, m_opponent, Shifts[i], Masks[i / 2], x);
+				move.flip |= GetFlipUpward(m_player, m_opponent, rays[i]);
+				move.flip |= GetFlipDownward(m_player, m_opponent, rays[i + 4]);
 			}
 
 			return move;
@@ -152,14 +244,12 @@ namespace OthelloAI
 		/// @return 評価値
 		int32 evaluate() const
 		{
-			constexpr int32 CellWeightScores[10] = { 2714, 147, 69, -18, -577, -186, -153, -379, -122, -169 };
-			constexpr uint64 CellWeightMasks[10] = { 0x8100000000000081ULL, 0x4281000000008142ULL, 0x2400810000810024ULL, 0x1800008181000018ULL, 0x0042000000004200ULL,
-				0x0024420000422400ULL, 0x0018004242001800ULL, 0x0000240000240000ULL, 0x0000182424180000ULL, 0x0000001818000000ULL };
 			int32 result = 0;
 
-			for (int32 i = 0; i < 10; ++i) // 盤面を10種類のマスに分けてそれぞれのマスに重みをつけたので、1種類ずつ計算
+			for (int32 row = 0; row < 8; ++row) // マスの重みを 1 行 8 マスずつまとめて事前計算した表を引く
 			{
-				result += CellWeightScores[i] * (pop_count_ull(m_player & CellWeightMasks[i]) - pop_count_ull(m_opponent & CellWeightMasks[i]));
+				const int32 shift = (row * 8);
+				result += (RowWeightTables[row][(m_player >> shift) & 0xFF] - RowWeightTables[row][(m_opponent >> shift) & 0xFF]);
 			}
 
 			result += (result > 0 ? 128 : (result < 0 ? -128 : 0));
@@ -188,8 +278,6 @@ namespace OthelloAI
 		[[nodiscard]]
 		BitBoard getLegalBitBoard() const
 		{
-			constexpr int32 Shifts[8] = { 1, -1, 8, -8, 7, -7, 9, -9 };
-			constexpr uint64 Masks[4] = { 0x7E7E7E7E7E7E7E7EULL, 0x00FFFFFFFFFFFF00ULL, 0x007E7E7E7E7E7E00ULL, 0x007E7E7E7E7E7E00ULL };
 			BitBoard result = 0ULL;
 
 			// 縦横斜めの8方向それぞれ別に計算する
@@ -246,6 +334,12 @@ namespace OthelloAI
 		// その盤面で打たない手番
 		BitBoard m_opponent = 0;
 
+		// 合法手の計算で使うシフト量
+		static constexpr int32 Shifts[8] = { 1, -1, 8, -8, 7, -7, 9, -9 };
+
+		// 合法手の計算で、盤の端を越えないようにするマスク
+		static constexpr uint64 Masks[4] = { 0x7E7E7E7E7E7E7E7EULL, 0x00FFFFFFFFFFFF00ULL, 0x007E7E7E7E7E7E00ULL, 0x007E7E7E7E7E7E00ULL };
+
 		// 負のシフトと正のシフトを同一に扱う関数
 		static constexpr uint64 EnhancedShift(uint64 a, int32 b)
 		{
@@ -266,33 +360,39 @@ namespace OthelloAI
 			return EnhancedShift(l, shift);
 		}
 
-		// 1 方向について着手 ｂ によって返る石を求める
-		static constexpr uint64 GetFlipPart(BitBoard player, BitBoard opponent, int32 shift, uint64 mask, uint64 x)
+		// ビットが増える方向の直線 ray について返る石を求める
+		static constexpr uint64 GetFlipUpward(BitBoard player, BitBoard opponent, uint64 ray)
 		{
-			uint64 o = (opponent & mask);
-			uint64 f = (EnhancedShift(x, shift) & o);
-			uint64 nf = 0ULL;
-			bool flipped = false;
+			const uint64 blocker = (ray & ~opponent); // 直線上で相手の石でないマス
+			const uint64 first = (blocker & (~blocker + 1)); // 着手位置から最も近いもの（最下位ビット）
 
-			for (int32 i = 0; i < 8; ++i)
+			if (first & player) // 自分の石で挟めていれば、その手前までが返る
 			{
-				nf = EnhancedShift(f, shift);
+				return ((first - 1) & ray);
+			}
 
-				if (nf & player)
-				{
-					flipped = true;
-					break;
-				}
+			return 0ULL;
+		}
 
-				f |= (nf & o);
-			}
+		// ビットが減る方向の直線 ray について返る石を求める
+		static constexpr uint64 GetFlipDownward(BitBoard player, BitBoard opponent, uint64 ray)
+		{
+			uint64 below = (ray & ~opponent); // 直線上で相手の石でないマス
+
+			// 着手位置から最も近いもの（最上位ビット）以下のビットをすべて立てる
+			below |= (below >> 1);
+			below |= (below >> 2);
+			below |= (below >> 4);
+			below |= (below >> 8);
+			below |= (below >> 16);
+			below |= (below >> 32);
 
-			if (not flipped)
+			if ((below ^ (below >> 1)) & player) // 自分の石で挟めていれば、その手前までが返る
 			{
-				f = 0ULL;
+				return (ray & ~below);
 			}
 
-			return f;
+			return 0ULL;
 		}
 	};
 
@@ -331,6 +431,8 @@ namespace OthelloAI
 		{
 			AbortTask(m_task);
 
+			m_slicedSearch.reset();
+
 			m_board.reset();
 
 			m_activeColor = OthelloAI::Color::Black;
@@ -393,6 +495,30 @@ namespace OthelloAI
 			return none;
 		}
 
+		/// @brief AI に現在の手番で最適な着手位置を、呼び出しごとに少しずつ計算してもらいます（スレッドを使わずに非同期で計算したい場合に使います）。
+		/// @param maxNodes 1 回の呼び出しで探索する局面数の上限（1 未満の場合は 1 として扱い、呼び出すたびに必ず探索が進むようにします）
+		/// @return 計算結果。計算途中の場合は none
+		[[nodiscard]]
+		Optional<AI_Result> calculateSliced(int32 maxNodes) const
+		{
+			// 探索が未開始の場合は
+			if (not m_slicedSearch)
+			{
+				// 探索を開始する
+				m_slicedSearch.emplace(m_board, m_depth);
+			}
+
+			// 探索が完了した場合は
+			if (const auto result = m_slicedSearch->resume(Max(maxNodes, 1)))
+			{
+				m_slicedSearch.reset();
+
+				return result;
+			}
+
+			return none;
+		}
+
 		/// @brief AI に現在の手番で最適な着手位置を計算してもらいます。
 		/// @return 計算結果
 		AI_Result calculate() const
@@ -495,6 +621,176 @@ namespace OthelloAI
 		// AI 非同期タスクの中断フラグ
 		inline static std::atomic<bool> m_abort = false;
 
+		// 中断・再開できる Nega-Alpha 法の探索。再帰の代わりに明示的なスタックを使う
+		class SlicedSearch
+		{
+		public:
+
+			SlicedSearch(const Board& board, int32 depth)
+				: m_board{ board }
+				, m_legal{ board.getLegalBitBoard() }
+				, m_depth{ depth }
+			{
+				m_stack.reserve(Max(depth, 0) + 1);
+			}
+
+			// 最大 maxNodes 局面だけ探索を進める。探索が完了した場合は結果を、それ以外の場合は none を返す
+			Optional<AI_Result> resume(int32 maxNodes)
+			{
+				for (int32 nodes = 0; nodes < maxNodes; ++nodes)
+				{
+					if (m_stack.isEmpty()) // ルートの局面
+					{
+						if (m_legal == 0ULL) // すべての合法手を調べ終えた
+						{
+							return m_result;
+						}
+
+						m_rootPos = first_bit(&m_legal);
+						m_legal &= (m_legal - 1);
+
+						Board board = m_board;
+						board.move(board.makeMove(m_rootPos)); // 着手
+
+						if (const auto value = enter(board, (m_depth - 1), -Board::MaxScore, -m_result.value, false))
+						{
+							leave(*value);
+						}
+
+						continue;
+					}
+
+					Frame& frame = m_stack.back();
+
+					if (frame.legal == 0ULL) // すべての合法手を調べ終えたか、枝刈りされた
+					{
+						const int32 value = (frame.passed ? -frame.alpha : frame.alpha);
+						m_stack.pop_back();
+						leave(value);
+						continue;
+					}
+
+					const BitBoardIndex pos = first_bit(&frame.legal);
+					frame.legal &= (frame.legal - 1);
+
+					Board board = frame.board;
+					board.move(board.makeMove(pos)); // 着手
+
+					// enter() で frame が無効になる可能性があるので、先に値をコピーしておく
+					const int32 depth = (frame.depth - 1);
+					const int32 alpha = -frame.beta;
+					const int32 beta = -frame.alpha;
+
+					if (const auto value = enter(board, depth, alpha, beta, false))
+					{
+						leave(*value);
+					}
+				}
+
+				return none;
+			}
+
+		private:
+
+			// 探索途中の局面
+			struct Frame
+			{
+				Board board;
+
+				// まだ調べていない合法手
+				BitBoard legal;
+
+				int32 depth;
+
+				int32 alpha;
+
+				int32 beta;
+
+				// パスして手番を入れ替えた局面であれば true（評価値の符号を反転して返す）
+				bool passed;
+			};
+
+			// ルートの局面
+			Board m_board;
+
+			// ルートの局面でまだ調べていない合法手
+			BitBoard m_legal;
+
+			// 先読みの手数
+			int32 m_depth;
+
+			// ルートの局面で調べている合法手
+			BitBoardIndex m_rootPos = 0;
+
+			// これまでの最善手
+			AI_Result m_result = { 0, (-Board::MaxScore - 1) };
+
+			Array<Frame> m_stack;
+
+			// 局面を探索し始める。すぐに評価値が決まる場合はその値を返し、それ以外の場合はスタックに積んで none を返す
+			Optional<int32> enter(Board board, int32 depth, int32 alpha, int32 beta, bool passed)
+			{
+				if (depth <= 0) // 探索終了
+				{
+					return board.evaluate();
+				}
+
+				BitBoard legal = board.getLegalBitBoard(); // 合法手生成
+
+				if (legal == 0ULL) // パスの場合
+				{
+					if (passed) // 2回パスしたら終局
+					{
+						return board.getScore();
+					}
+
+					// 手番を入れ替えてもう一度探索
+					board.pass();
+
+					legal = board.getLegalBitBoard();
+
+					if (legal == 0ULL) // 相手も打てなければ終局
+					{
+						return -board.getScore();
+					}
+
+					m_stack.push_back(Frame{ board, legal, depth, -beta, -alpha, true });
+
+					return none;
+				}
+
+				m_stack.push_back(Frame{ board, legal, depth, alpha, beta, false });
+
+				return none;
+			}
+
+			// 局面の評価値が決まったので、1 つ前の局面に戻る
+			void leave(int32 value)
+			{
+				if (m_stack.isEmpty()) // ルートの局面
+				{
+					if (m_result.value < -value) // これまで見た評価値よりも良い評価値なら値を更新
+					{
+						m_result = { m_rootPos, -value };
+					}
+
+					return;
+				}
+
+				Frame& parent = m_stack.back();
+
+				parent.alpha = Max(parent.alpha, -value); // 次の手番の探索結果
+
+				if (parent.beta <= parent.alpha) // 途中で枝刈りできる場合はする
+				{
+					parent.legal = 0ULL;
+				}
+			}
+		};
+
+		// 少しずつ進める AI の探索
+		mutable Optional<SlicedSearch> m_slicedSearch;
+
 		// 2 進数として数値を見て右端からいくつ 0 が連続しているか: Number of Training Zero
 		static uint_fast8_t ntz(uint64* x)
 		{
@@ -833,10 +1129,15 @@ void Main()
 					// AI による着手
 				# if SIV3D_PLATFORM(WEB)
 
-					const auto result = game.calculate();
-					const auto record = game.move(result.pos);
-					value = result.value;
-					stopwatch.restart();
+					// 1 フレームあたりに探索する局面数（Web ではスレッドを使わず、描画を止めないように少しずつ計算する）
+					constexpr int32 AINodesPerFrame = 5000;
+
+					if (const auto result = game.calculateSliced(AINodesPerFrame))
+					{
+						const auto record = game.move(result->pos);
+						value = result->value;
+						stopwatch.restart();
+					}
 
 				# else
 
@@ -0,0 +1,36 @@
+# pragma once
+# include <Siv3D.hpp>
+# include <atomic>
+
+/// @brief プログラム全体でのメモリ確保の回数を数えるカウンタ
+/// @remark TOPDOWNSHOOTER_COUNT_ALLOCATIONS を定義してビルドしたときだけ、Main.cpp でグローバルな operator new（アライメント指定版と nothrow 版を含む）を置き換えて、呼ばれるたびに Increment() します。
+/// 定義しない場合は置き換えず、Get() は常に 0 を返します。置き換えはプログラム全体で 1 つだけでなければならないので、このヘッダにはカウンタだけを置きます。
+/// カウンタはすべてのスレッドで共有するので、ある区間の前後で Get() の差をとると、その間にワーカースレッドや Siv3D の内部のスレッド（音声やアセットの読み込みなど）が行った確保も含まれます。
+/// 数えた回数は、その区間で確保が起こったかどうかの目安として使ってください。
+namespace AllocationCounter
+{
+	/// @brief メモリ確保の回数を数えるようにビルドされているか
+# if defined(TOPDOWNSHOOTER_COUNT_ALLOCATIONS)
+	inline constexpr bool Enabled = true;
+# else
+	inline constexpr bool Enabled = false;
+# endif
+
+	namespace detail
+	{
+		inline std::atomic<uint64> count{ 0 };
+	}
+
+	/// @brief メモリ確保の回数を 1 増やします。
+	inline void Increment() noexcept
+	{
+		detail::count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// @brief これまでのメモリ確保の回数を返します。
+	[[nodiscard]]
+	inline uint64 Get() noexcept
+	{
+		return detail::count.load(std::memory_order_relaxed);
+	}
+}
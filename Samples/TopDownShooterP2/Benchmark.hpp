@@ -0,0 +1,376 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Common.hpp"
+# include "Bullets.hpp"
+# include "LightBullets.hpp"
+# include "Rollback.hpp"
+
+/// @brief 弾の処理のベンチマークの設定
+struct BulletBenchmarkConfig
+{
+	/// @brief 最初に発射しておく弾の数
+	size_t bulletCount = 1000;
+
+	/// @brief シミュレーションするステップ数
+	int32 stepCount = 200;
+
+	/// @brief 弾の配置のシード
+	uint64 seed = 0;
+};
+
+/// @brief 弾の処理のベンチマークの結果
+struct BulletBenchmarkResult
+{
+	/// @brief P2Body の弾の 1 ステップあたりの時間（ミリ秒）
+	double physicsMillisec = 0.0;
+
+	/// @brief 軽量な弾の 1 ステップあたりの時間（ミリ秒）
+	double lightMillisec = 0.0;
+
+	/// @brief P2Body の弾が壁や敵ユニットに当たった回数
+	int64 physicsHitCount = 0;
+
+	/// @brief 軽量な弾が壁や敵ユニットに当たった回数
+	int64 lightHitCount = 0;
+};
+
+/// @brief ゲームと同じ壁と敵ユニットの配置で、同じ初期状態の弾を P2Body の弾と軽量な弾のそれぞれでシミュレーションし、1 ステップあたりの時間を計測します。
+/// @param config ベンチマークの設定
+/// @return ベンチマークの結果
+/// @remark 弾は範囲内のランダムな位置からランダムな向きに発射します。時間には、空気抵抗・移動・衝突判定・衝突イベントの構築・当たった弾と領域外の弾の削除を含みます。
+inline BulletBenchmarkResult RunBulletBenchmark(const BulletBenchmarkConfig& config)
+{
+	constexpr double StepSec = (1.0 / 200.0);
+	constexpr double Speed = 500.0;
+	const RectF GameBounds{ -400, -250, 800, 500 };
+	const Array<RectF> wallRects = { RectF{ -300, -210, 600, 20 }, RectF{ -300, 190, 600, 20 } };
+	const Array<Vec2> enemyPositions = { Vec2{ 200, 100 }, Vec2{ 300, 100 } };
+	constexpr double EnemyRadius = 40.0;
+
+	// 弾の初期状態
+	Array<std::pair<Vec2, Vec2>> shots(config.bulletCount);
+	{
+		DefaultRNG rng{ config.seed };
+
+		for (auto& shot : shots)
+		{
+			shot.first = RandomVec2(GameBounds, rng);
+			shot.second = RandomVec2(Speed, rng);
+		}
+	}
+
+	BulletBenchmarkResult result;
+	Array<CollisionEvent> events;
+
+	// P2Body の弾
+	{
+		P2World world{ 0.0 };
+		Array<P2Body> bodies;
+
+		for (const auto& rect : wallRects)
+		{
+			bodies << world.createRect(P2Static, rect.center(), rect.size, {}, WallFilter);
+		}
+
+		for (const auto& pos : enemyPositions)
+		{
+			bodies << world.createCircle(P2Kinematic, pos, EnemyRadius, {}, EnemyUnitFilter);
+		}
+
+		BulletList bulletList;
+		bulletList.reserve(world, shots.size());
+
+		for (const auto& [pos, velocity] : shots)
+		{
+			bulletList.fire(world, pos, velocity, 1.0, 0.0);
+		}
+
+		const uint64 start = Time::GetNanosec();
+
+		for (int32 i = 0; i < config.stepCount; ++i)
+		{
+			bulletList.applyAirResistance(StepSec);
+			world.update(StepSec);
+
+			for (auto&& [pair, collision] : world.getCollisions())
+			{
+				if ((not bulletList.isBullet(pair.a))
+					&& (not bulletList.isBullet(pair.b)))
+				{
+					continue;
+				}
+
+				for (const auto& c : collision)
+				{
+					events << CollisionEvent{ .a = pair.a, .b = pair.b, .pos = c.point, .normalImpulse = c.normalImpulse, .tangentImpulse = Abs(c.tangentImpulse), .timestamp = (i * StepSec) };
+				}
+
+				bulletList.remove(pair.a);
+				bulletList.remove(pair.b);
+			}
+
+			bulletList.removeExpired(GameBounds, -Math::Inf);
+		}
+
+		result.physicsMillisec = ((Time::GetNanosec() - start) / 1e6 / config.stepCount);
+		result.physicsHitCount = static_cast<int64>(events.size());
+	}
+
+	events.clear();
+
+	// 軽量な弾
+	{
+		// 弾の質量を調べるためだけに使う
+		P2World world{ 0.0 };
+		Array<RectTarget> walls;
+		Array<CircleTarget> targets;
+		P2BodyID id = 0;
+
+		for (const auto& rect : wallRects)
+		{
+			walls << RectTarget{ ++id, rect };
+		}
+
+		for (const auto& pos : enemyPositions)
+		{
+			targets << CircleTarget{ ++id, Circle{ pos, EnemyRadius } };
+		}
+
+		const StaticBVH wallBVH{ walls };
+		UniformGrid grid{ GameBounds, (EnemyRadius * 2) };
+		LightBulletList bulletList{ GetBulletMassPerDensity(world) };
+		bulletList.reserve(shots.size());
+
+		for (const auto& [pos, velocity] : shots)
+		{
+			bulletList.fire(pos, velocity, 1.0, 0.0);
+		}
+
+		const uint64 start = Time::GetNanosec();
+
+		for (int32 i = 0; i < config.stepCount; ++i)
+		{
+			grid.build(targets);
+			bulletList.update(StepSec, GameBounds, -Math::Inf, wallBVH, targets, grid, (i * StepSec), events);
+		}
+
+		result.lightMillisec = ((Time::GetNanosec() - start) / 1e6 / config.stepCount);
+		result.lightHitCount = static_cast<int64>(events.size());
+	}
+
+	return result;
+}
+
+/// @brief ロールバックのベンチマークの設定
+struct RollbackBenchmarkConfig
+{
+	/// @brief 通信の遅延（秒）
+	double latencySec = 0.05;
+
+	/// @brief 通信の遅延のゆらぎの最大値（秒）
+	double jitterSec = 0.01;
+
+	/// @brief シミュレーションするステップ数
+	int32 stepCount = 2000;
+
+	/// @brief 遅延のゆらぎのシード
+	uint64 seed = 0;
+};
+
+/// @brief ロールバックのベンチマークの結果
+struct RollbackBenchmarkResult
+{
+	/// @brief ロールバックを除いた、1 ステップあたりの時間（ミリ秒）
+	double millisecPerStep = 0.0;
+
+	/// @brief プレイヤー 0 のセッションのロールバックの統計
+	RollbackStats stats;
+
+	/// @brief すべての操作が届いた後の 2 つのセッションの状態が、ビット単位で一致したか
+	bool consistent = false;
+};
+
+/// @brief 2 人のプレイヤーのセッションを、遅延のある通信路でつないで自動で操作し、ロールバックにかかる時間を計測します。
+/// @param config ベンチマークの設定
+/// @return ベンチマークの結果
+/// @remark 通信路の時刻はステップ単位で進めるので、実行環境の速さによらず同じステップでロールバックが起こります。
+inline RollbackBenchmarkResult RunRollbackBenchmark(const RollbackBenchmarkConfig& config)
+{
+	LoopbackChannel network{ LoopbackConfig{ .latencySec = config.latencySec, .jitterSec = config.jitterSec, .seed = config.seed } };
+	std::array<RollbackSession, Simulation::PlayerCount> sessions = { RollbackSession{ 0, network.endpoint(0) }, RollbackSession{ 1, network.endpoint(1) } };
+
+	const uint64 start = Time::GetNanosec();
+
+	for (int32 i = 0; i < config.stepCount; ++i)
+	{
+		network.update(Simulation::StepSec);
+
+		for (auto& session : sessions)
+		{
+			static_cast<void>(session.advance(MakeAutoInput(session.simulation().stepCount(), session.localPlayer())));
+		}
+	}
+
+	const double totalMillisec = ((Time::GetNanosec() - start) / 1e6);
+
+	// すべての操作を届けて、予測が外れていたステップをやり直させる
+	network.update(config.latencySec + config.jitterSec + Simulation::StepSec);
+
+	for (auto& session : sessions)
+	{
+		session.poll();
+	}
+
+	RollbackBenchmarkResult result;
+	result.stats = sessions[0].stats();
+	result.millisecPerStep = ((totalMillisec - result.stats.resimulationMillisec) / config.stepCount);
+
+	if (sessions[0].simulation().stepCount() == sessions[1].simulation().stepCount())
+	{
+		Array<uint8> state0, state1;
+		sessions[0].simulation().save(state0);
+		sessions[1].simulation().save(state1);
+		result.consistent = (state0 == state1);
+	}
+
+	return result;
+}
+
+/// @brief 1 ステップの処理の並列化のベンチマークの結果
+struct StepBenchmarkResult
+{
+	/// @brief 1 つのスレッドで実行した場合の、1 ステップあたりの時間（ミリ秒）
+	double serialMillisec = 0.0;
+
+	/// @brief ワーカースレッドで並列に実行した場合の、1 ステップあたりの時間（ミリ秒）
+	double parallelMillisec = 0.0;
+
+	/// @brief 最後の P2Body の弾の数
+	size_t bulletCount = 0;
+
+	/// @brief 2 つの場合の最後の状態が、ビット単位で一致したか
+	bool consistent = false;
+};
+
+/// @brief 2 人のプレイヤーが毎ステップ弾を撃つ操作を返します。
+/// @param step ステップ数
+/// @return 指定したステップの、すべてのプレイヤーの操作
+/// @remark プレイヤー 0 は P2Body の弾を、プレイヤー 1 は軽量な弾を撃ちます。
+[[nodiscard]]
+inline Simulation::PlayerInputs MakeBenchmarkInputs(uint64 step)
+{
+	Simulation::PlayerInputs inputs;
+
+	for (size_t player = 0; player < Simulation::PlayerCount; ++player)
+	{
+		inputs[player] = MakeAutoInput(step, player);
+		inputs[player].shot = ((step % 2) ? ShotType::Heavy : ShotType::Light);
+		inputs[player].lightBulletMode = (player == 1);
+	}
+
+	return inputs;
+}
+
+/// @brief 2 人のプレイヤーが毎ステップ弾を撃つシミュレーションを、1 つのスレッドとワーカースレッドのそれぞれで実行し、1 ステップあたりの時間を計測します。
+/// @param stepCount シミュレーションするステップ数
+/// @param pool ワーカースレッド
+/// @return ベンチマークの結果
+/// @remark 操作は MakeBenchmarkInputs() で決めます。
+inline StepBenchmarkResult RunStepBenchmark(int32 stepCount, WorkerPool& pool)
+{
+	const auto run = [&](Simulation& simulation)
+		{
+			const uint64 start = Time::GetNanosec();
+
+			for (int32 i = 0; i < stepCount; ++i)
+			{
+				simulation.step(MakeBenchmarkInputs(simulation.stepCount()));
+			}
+
+			return ((Time::GetNanosec() - start) / 1e6 / stepCount);
+		};
+
+	StepBenchmarkResult result;
+
+	Simulation serial;
+	result.serialMillisec = run(serial);
+	result.bulletCount = serial.bulletCount();
+
+	Simulation parallel;
+	parallel.setWorkerPool(&pool);
+	result.parallelMillisec = run(parallel);
+
+	Array<uint8> state0, state1;
+	serial.save(state0);
+	parallel.save(state1);
+	result.consistent = (state0 == state1);
+
+	return result;
+}
+
+/// @brief 状態の復元の確認の結果
+struct RestoreCheckResult
+{
+	/// @brief 保存した状態のバイト数
+	size_t stateSize = 0;
+
+	/// @brief 保存したときの P2Body の弾の数
+	size_t bulletCount = 0;
+
+	/// @brief 復元してから進めた後の状態が、同じシミュレーションで 2 回復元した場合と、別のシミュレーションで復元した場合のすべてで、ビット単位で一致したか
+	bool consistent = false;
+};
+
+/// @brief 状態を保存してから指定したステップ数だけ進め、保存した状態を load() して同じ操作でもう一度進めたときに、同じ状態になるかを確かめます。
+/// @param stepCount 保存するまでと、復元してから進めるステップ数
+/// @return 確認の結果
+/// @remark 同じシミュレーションで 2 回と、保存したのとは別のシミュレーションで 1 回復元し、それぞれ stepCount ステップ進めた状態を比べます。
+/// 操作は MakeBenchmarkInputs() で決めるので、弾が壁や敵ユニットに当たったり、プールの P2Body が使い回されたりする状態を含みます。
+inline RestoreCheckResult RunRestoreCheck(int32 stepCount)
+{
+	const auto run = [&](Simulation& simulation)
+		{
+			for (int32 i = 0; i < stepCount; ++i)
+			{
+				simulation.step(MakeBenchmarkInputs(simulation.stepCount()));
+			}
+		};
+
+	RestoreCheckResult result;
+
+	Simulation simulation;
+	run(simulation);
+
+	Array<uint8> saved;
+	simulation.save(saved);
+	result.stateSize = saved.size();
+	result.bulletCount = simulation.bulletCount();
+
+	// 保存した状態から進めた状態を、3 通りの方法で求める
+	std::array<Array<uint8>, 3> states;
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		if (not simulation.load(saved))
+		{
+			return result;
+		}
+
+		run(simulation);
+		simulation.save(states[i]);
+	}
+
+	Simulation other;
+
+	if (not other.load(saved))
+	{
+		return result;
+	}
+
+	run(other);
+	other.save(states[2]);
+
+	result.consistent = ((states[0] == states[1]) && (states[0] == states[2]));
+
+	return result;
+}
@@ -0,0 +1,538 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Collision.hpp"
+# include "Common.hpp"
+# include "Snapshot.hpp"
+
+/// @brief 弾の P2Body を使い回すプール
+/// @remark 使っていない P2Body は、どれとも干渉しないフィルタを設定し、ワールドの遠くにそれぞれ別の位置に止めて眠らせておきます。
+/// 発射のたびに物理演算ワールドに物体を作ったり消したりしないので、連射しても定常状態ではワールド内のメモリ確保が起こりません。
+/// P2Body は作った順のインデックスで扱います。状態を戻すときは、保存したときと同じ数の P2Body を同じ順に作り直すので、保存したときのインデックスで、同じ役割の P2Body を指せます。
+class BulletBodyPool
+{
+public:
+
+	/// @brief 使っていない P2Body を指定した個数になるまで作っておく
+	/// @param world 物理演算ワールド
+	/// @param count 個数
+	void reserve(P2World& world, size_t count)
+	{
+		while (m_free.size() < count)
+		{
+			m_free << static_cast<uint32>(m_bodies.size());
+			create(world);
+		}
+	}
+
+	/// @brief P2Body を取り出す。使っていないものが無ければ、これまでに作った数だけ追加で作る
+	/// @param world 物理演算ワールド
+	/// @param pos 位置
+	/// @param velocity 速度
+	/// @param density 密度 (kg / m^2)
+	/// @param filter 干渉フィルタ
+	/// @return P2Body のインデックス
+	[[nodiscard]]
+	uint32 acquire(P2World& world, const Vec2& pos, const Vec2& velocity, double density, const P2Filter& filter)
+	{
+		if (m_free.isEmpty())
+		{
+			reserve(world, Max<size_t>(m_bodies.size(), 16));
+		}
+
+		const uint32 index = m_free.back();
+		m_free.pop_back();
+
+		// 前に使ったときの角度と角速度は残さない
+		activate(index, pos, 0.0, velocity, 0.0, density, filter);
+
+		return index;
+	}
+
+	/// @brief 使い終わった P2Body を返す
+	/// @param index P2Body のインデックス
+	void release(uint32 index)
+	{
+		park(m_bodies[index]);
+		m_free << index;
+	}
+
+	/// @brief 指定したインデックスの P2Body を返す
+	[[nodiscard]]
+	const P2Body& operator [](uint32 index) const
+	{
+		return m_bodies[index];
+	}
+
+	/// @brief 使っていない P2Body の個数を返す
+	[[nodiscard]]
+	size_t freeCount() const noexcept
+	{
+		return m_free.size();
+	}
+
+	/// @brief これまでに作った P2Body の個数を返す
+	[[nodiscard]]
+	size_t createdCount() const noexcept
+	{
+		return m_bodies.size();
+	}
+
+	/// @brief 作った P2Body の個数と、使っていない P2Body の並びを書き込む
+	/// @param writer 書き込み先
+	void save(StateWriter& writer) const
+	{
+		writer.write(static_cast<uint64>(m_bodies.size()));
+		writer.writeArray(m_free);
+	}
+
+	/// @brief すべての P2Body を削除する
+	void clear()
+	{
+		m_bodies.clear();
+		m_free.clear();
+	}
+
+	/// @brief 指定した P2Body を使っている状態に戻す
+	/// @param index P2Body のインデックス
+	/// @param pos 位置
+	/// @param angle 角度
+	/// @param velocity 速度
+	/// @param angularVelocity 角速度
+	/// @param density 密度 (kg / m^2)
+	/// @param filter 干渉フィルタ
+	/// @return 戻せた場合 true, インデックスが正しくない場合は false
+	/// @remark 状態の復元に、load() の後で使います。
+	[[nodiscard]]
+	bool restore(uint32 index, const Vec2& pos, double angle, const Vec2& velocity, double angularVelocity, double density, const P2Filter& filter)
+	{
+		if (m_bodies.size() <= index)
+		{
+			return false;
+		}
+
+		activate(index, pos, angle, velocity, angularVelocity, density, filter);
+		return true;
+	}
+
+	/// @brief すべての P2Body を削除し、保存したときと同じ数の P2Body を作り直して、使っていない P2Body の並びを読み込む
+	/// @param reader 読み込み元
+	/// @param world 物理演算ワールド
+	/// @return 読み込めた場合 true, それ以外の場合は false
+	/// @remark 作り直した P2Body は、すべて使っていない状態です。使っている P2Body は、この後 restore() で戻します。
+	[[nodiscard]]
+	bool load(StateReader& reader, P2World& world)
+	{
+		clear();
+
+		uint64 createdCount;
+
+		if ((not reader.read(createdCount)) || (MaxBodyCount < createdCount)
+			|| (not reader.readArray(m_free)))
+		{
+			return false;
+		}
+
+		m_bodies.reserve(static_cast<size_t>(createdCount));
+
+		while (m_bodies.size() < createdCount)
+		{
+			create(world);
+		}
+
+		return std::all_of(m_free.begin(), m_free.end(), [&](uint32 index) { return (index < m_bodies.size()); });
+	}
+
+private:
+
+	// どれとも干渉しないフィルタ
+	static constexpr P2Filter InactiveFilter{ .categoryBits = 0, .maskBits = 0 };
+
+	// 使っていない P2Body を止めておく領域の左上
+	static constexpr Vec2 ParkingOrigin{ -100000, -100000 };
+
+	// 状態から読み込む、作った P2Body の個数の上限（壊れた状態で大量の P2Body を作らないようにする）
+	static constexpr uint64 MaxBodyCount = (1 << 24);
+
+	// 作った P2Body（作った順）
+	Array<P2Body> m_bodies;
+
+	// 使っていない P2Body のインデックス
+	Array<uint32> m_free;
+
+	// 使っていない P2Body を作って、末尾に加える
+	void create(P2World& world)
+	{
+		P2Body body = world.createCircle(P2Dynamic, Vec2{ 0, 0 }, BulletRadius, P2Material{ .density = 1.0 }, InactiveFilter);
+		park(body);
+		m_bodies << std::move(body);
+	}
+
+	// 干渉するようにして、指定した状態で動かす
+	void activate(uint32 index, const Vec2& pos, double angle, const Vec2& velocity, double angularVelocity, double density, const P2Filter& filter)
+	{
+		P2Body& body = m_bodies[index];
+		body.shape(0).setDensity(density);
+		body.shape(0).setFilter(filter);
+		body.setPos(pos);
+		body.setAngle(angle);
+		body.setVelocity(velocity);
+		body.setAngularVelocity(angularVelocity);
+		body.setAwake(true);
+	}
+
+	// 干渉しないようにして、P2BodyID ごとに決まる位置に止めて眠らせる
+	// （同じ位置に重ねると、ブロードフェーズで止めてある P2Body どうしの組を毎回調べることになる）
+	static void park(P2Body& body)
+	{
+		const uint64 id = body.id();
+
+		body.shape(0).setFilter(InactiveFilter);
+		body.setVelocity(Vec2{ 0, 0 });
+		body.setPos(ParkingOrigin + Vec2{ ((id % 256) * (BulletRadius * 4)), ((id / 256) * (BulletRadius * 4)) });
+		body.setAwake(false);
+	}
+};
+
+/// @brief すべての弾の管理クラス
+/// @remark 弾は密な配列に詰めて持ち、P2BodyID から配列のインデックスを引く表を別に持ちます。
+/// 弾の削除は最後の弾との入れ替え (swap-and-pop) で O(1), 領域外や期限切れの弾の削除は 1 回の走査でまとめて詰めます。
+/// 弾の P2Body はプールから取り出し、削除するとプールに返します。
+class BulletList
+{
+public:
+
+	/// @brief 弾を発射する
+	/// @param world 物理演算ワールド
+	/// @param from 発射位置
+	/// @param velocity 発射速度
+	/// @param density 弾の密度 (kg / m^2)
+	/// @param timeStamp 発射時刻
+	void fire(P2World& world, const Vec2& from, const Vec2& velocity, double density, TimestampSec timestamp)
+	{
+		const uint32 poolIndex = m_pool.acquire(world, from, velocity, density, FriendBulletFilter);
+		const P2Body& body = m_pool[poolIndex];
+		// body.setBullet(true) による連続衝突判定 (OpenSiv3D v0.6.6 以降) は使わず、高速な弾のすり抜けは sweepFastBullets() で防ぐ
+		m_indices.emplace(body.id(), m_bullets.size());
+		m_bullets << Bullet{ body, poolIndex, timestamp, from };
+	}
+
+	/// @brief 弾の P2Body を指定した個数だけ作っておく
+	/// @param world 物理演算ワールド
+	/// @param count 個数
+	void reserve(P2World& world, size_t count)
+	{
+		m_pool.reserve(world, count);
+	}
+
+	/// @brief すべての弾に空気抵抗相当の力を与える
+	/// @param dt タイムステップ
+	void applyAirResistance(double dt)
+	{
+		applyAirResistance(dt, 0, m_bullets.size());
+	}
+
+	/// @brief 指定した範囲の弾に空気抵抗相当の力を与える
+	/// @param dt タイムステップ
+	/// @param begin 範囲の最初の弾のインデックス
+	/// @param end 範囲の最後の弾の次のインデックス
+	/// @remark 弾ごとに自分の P2Body だけを変更するので、範囲が重ならなければ、複数のスレッドから同時に呼べます。
+	void applyAirResistance(double dt, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			P2Body& body = m_bullets[i].body;
+
+			// 速さに比例した空気抵抗
+			body.applyLinearImpulse(-body.getVelocity() * dt * BulletAirResistance);
+		}
+	}
+
+	/// @brief 指定した範囲の弾の現在の位置を、移動前の位置として記録する
+	/// @param begin 範囲の最初の弾のインデックス
+	/// @param end 範囲の最後の弾の次のインデックス
+	/// @remark 物理演算ワールドを更新する前に呼びます。範囲が重ならなければ、複数のスレッドから同時に呼べます。
+	void savePreviousPositions(size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			m_bullets[i].previousPos = m_bullets[i].body.getPos();
+		}
+	}
+
+	/// @brief 1 ステップで minDistance 以上動いた弾について、移動前の位置から現在の位置までを掃引した円と壁・標的との衝突を調べ、最初に触れたものとの衝突イベントを追加する
+	/// @param minDistance 調べる弾の 1 ステップの移動距離の最小値
+	/// @param walls 壁を登録した境界ボリューム階層
+	/// @param targets 標的
+	/// @param grid 標的を登録した空間ハッシュ
+	/// @param timestamp 現在のゲーム時刻
+	/// @param events 衝突イベントの追加先。すでに衝突イベントがある弾は調べない
+	/// @remark 物理演算エンジンの衝突判定はステップの終わりの位置でだけ行うので、1 ステップで壁や標的の厚さより長く動く弾は、接触が検出されずにすり抜けます。
+	/// 弾ごとの連続衝突判定 (P2Body::setBullet) の代わりに、速い弾だけを線分で調べて補います。弾は止まり（反発係数 0）、標的は動かないものとして衝突の力を求めます。
+	void sweepFastBullets(double minDistance, const StaticBVH& walls, const Array<CircleTarget>& targets, const UniformGrid& grid, TimestampSec timestamp, Array<CollisionEvent>& events)
+	{
+		// 物理演算エンジンが接触を検出した弾（衝突イベントは少ないので、ソートした配列を二分探索する）
+		m_contactedIDs.clear();
+
+		for (const auto& event : events)
+		{
+			m_contactedIDs << event.a << event.b;
+		}
+
+		std::sort(m_contactedIDs.begin(), m_contactedIDs.end());
+
+		const double minDistanceSq = (minDistance * minDistance);
+
+		for (const auto& bullet : m_bullets)
+		{
+			const Vec2 pos = bullet.body.getPos();
+			const Vec2 delta = (pos - bullet.previousPos);
+
+			if ((delta.lengthSq() < minDistanceSq)
+				|| std::binary_search(m_contactedIDs.begin(), m_contactedIDs.end(), bullet.body.id()))
+			{
+				continue;
+			}
+
+			if (const auto hit = FindFirstHit(bullet.previousPos, delta, BulletRadius, walls, targets, grid))
+			{
+				events << MakeSweepCollisionEvent(*hit, bullet.body.id(), bullet.previousPos, delta, bullet.body.getVelocity(), bullet.body.getMass(), timestamp);
+			}
+		}
+	}
+
+	/// @brief 指定した P2BodyID の弾を削除する
+	/// @param id 削除する弾の P2BodyID
+	void remove(P2BodyID id)
+	{
+		const auto it = m_indices.find(id);
+
+		if (it == m_indices.end())
+		{
+			return;
+		}
+
+		const size_t index = it->second;
+		m_indices.erase(it);
+		m_pool.release(m_bullets[index].poolIndex);
+
+		// 最後の弾を空いた場所に移す
+		if (index != (m_bullets.size() - 1))
+		{
+			m_bullets[index] = std::move(m_bullets.back());
+			m_indices[m_bullets[index].body.id()] = index;
+		}
+
+		m_bullets.pop_back();
+	}
+
+	/// @brief 指定した領域外の弾と、指定したタイムスタンプ未満の弾をまとめて削除する
+	/// @param bounds 領域
+	/// @param t タイムスタンプ
+	void removeExpired(const RectF& bounds, TimestampSec t)
+	{
+		// 残す弾を前に詰める
+		size_t count = 0;
+
+		for (size_t i = 0; i < m_bullets.size(); ++i)
+		{
+			Bullet& bullet = m_bullets[i];
+
+			if ((bullet.timestamp < t) || (not bullet.body.getPos().intersects(bounds)))
+			{
+				m_indices.erase(bullet.body.id());
+				m_pool.release(bullet.poolIndex);
+				continue;
+			}
+
+			if (i != count)
+			{
+				m_bullets[count] = std::move(bullet);
+				m_indices[m_bullets[count].body.id()] = count;
+			}
+
+			++count;
+		}
+
+		// 詰め終わった後ろの部分をまとめて削除する
+		m_bullets.resize(count);
+	}
+
+	/// @brief すべての弾を描画する
+	void draw() const
+	{
+		for (const auto& bullet : m_bullets)
+		{
+			const Vec2 pos = bullet.body.getPos();
+
+			Circle{ pos, BulletRadius }.draw();
+
+			if (5.0 <= bullet.body.shape(0).getDensity())
+			{
+				Circle{ pos, 8 }.drawFrame(1);
+			}
+		}
+	}
+
+	/// @brief 指定した P2Body が弾であるかを返す。
+	/// @param id P2BodyID
+	/// @return 指定した P2Body が弾である場合 true, それ以外の倍は false
+	bool isBullet(P2BodyID id) const
+	{
+		return m_indices.contains(id);
+	}
+
+	/// @brief アクティブな弾の数を返す
+	[[nodiscard]]
+	size_t size() const noexcept
+	{
+		return m_bullets.size();
+	}
+
+	/// @brief 弾の状態を書き込む
+	/// @param writer 書き込み先
+	void save(StateWriter& writer) const
+	{
+		writer.write(static_cast<uint64>(m_bullets.size()));
+
+		for (const auto& bullet : m_bullets)
+		{
+			writer.write(bullet.poolIndex);
+			writer.write(bullet.timestamp);
+			writer.write(bullet.body.getPos());
+			writer.write(bullet.body.getAngle());
+			writer.write(bullet.body.getVelocity());
+			writer.write(bullet.body.getAngularVelocity());
+			writer.write(bullet.body.shape(0).getDensity());
+		}
+
+		m_pool.save(writer);
+	}
+
+	/// @brief すべての弾を、プールの P2Body とともに削除する
+	void clear()
+	{
+		m_bullets.clear();
+		m_indices.clear();
+		m_pool.clear();
+	}
+
+	/// @brief 弾の状態を読み込む
+	/// @param reader 読み込み元
+	/// @param world 物理演算ワールド
+	/// @return 読み込めた場合 true, それ以外の場合は false
+	/// @remark 今ある弾とプールの P2Body をすべて削除し、プールの P2Body を保存したときと同じ数だけ同じ順に作り直してから、
+	/// 弾の P2Body の位置・角度・速度・角速度・密度を、保存したときの値にビット単位で戻します。
+	[[nodiscard]]
+	bool load(StateReader& reader, P2World& world)
+	{
+		clear();
+
+		uint64 count;
+
+		if (not reader.read(count))
+		{
+			return false;
+		}
+
+		// プールの並びは弾の後ろに書き込んであるので、弾はいったん読み込んでおく
+		Array<SavedBullet> saved;
+
+		for (uint64 i = 0; i < count; ++i)
+		{
+			SavedBullet bullet;
+
+			if ((not reader.read(bullet.poolIndex)) || (not reader.read(bullet.timestamp)) || (not reader.read(bullet.pos))
+				|| (not reader.read(bullet.angle)) || (not reader.read(bullet.velocity)) || (not reader.read(bullet.angularVelocity))
+				|| (not reader.read(bullet.density)))
+			{
+				return false;
+			}
+
+			saved << bullet;
+		}
+
+		if (not m_pool.load(reader, world))
+		{
+			return false;
+		}
+
+		for (const auto& bullet : saved)
+		{
+			if (not m_pool.restore(bullet.poolIndex, bullet.pos, bullet.angle, bullet.velocity, bullet.angularVelocity, bullet.density, FriendBulletFilter))
+			{
+				return false;
+			}
+
+			const P2Body& body = m_pool[bullet.poolIndex];
+			m_indices.emplace(body.id(), m_bullets.size());
+			m_bullets << Bullet{ body, bullet.poolIndex, bullet.timestamp, bullet.pos };
+		}
+
+		return true;
+	}
+
+	/// @brief 状態を Print する
+	void showStats() const
+	{
+		assert(m_bullets.size() == m_indices.size());
+		Print << U"active bullets: {}"_fmt(m_bullets.size());
+		Print << U"pooled bodies: {} / {}"_fmt(m_pool.freeCount(), m_pool.createdCount());
+	}
+
+private:
+
+	struct Bullet
+	{
+		P2Body body;
+
+		// プールでの P2Body のインデックス
+		uint32 poolIndex;
+
+		// 発射時刻
+		TimestampSec timestamp;
+
+		// 直前の物理演算ワールドの更新の前の位置（保存せず、各ステップの最初に記録し直す）
+		Vec2 previousPos;
+	};
+
+	// load() で読み込んだ弾
+	struct SavedBullet
+	{
+		uint32 poolIndex;
+
+		TimestampSec timestamp;
+
+		Vec2 pos;
+
+		double angle;
+
+		Vec2 velocity;
+
+		double angularVelocity;
+
+		double density;
+	};
+
+	// アクティブな弾
+	Array<Bullet> m_bullets;
+
+	// アクティブな弾の P2BodyID → m_bullets のインデックス
+	HashTable<P2BodyID, size_t> m_indices;
+
+	// 弾の P2Body のプール
+	BulletBodyPool m_pool;
+
+	// sweepFastBullets() で、接触が検出された弾の P2BodyID を並べる配列（使い回す）
+	Array<P2BodyID> m_contactedIDs;
+};
+
+/// @brief 密度 1 の弾の P2Body の質量を返す
+/// @param world 物理演算ワールド
+/// @return 質量
+/// @remark 質量は形と密度だけで決まるので、どれとも干渉しない P2Body を一時的に作って調べます。
+[[nodiscard]]
+inline double GetBulletMassPerDensity(P2World& world)
+{
+	const P2Body probe = world.createCircle(P2Dynamic, Vec2{ 0, 0 }, BulletRadius, P2Material{ .density = 1.0 }, P2Filter{ .categoryBits = 0, .maskBits = 0 });
+	return probe.getMass();
+}
@@ -0,0 +1,479 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Common.hpp"
+
+/// @brief 弾が当たる円形の標的（敵ユニット）
+struct CircleTarget
+{
+	/// @brief 標的の P2BodyID
+	P2BodyID id;
+
+	/// @brief 標的の形
+	Circle circle;
+};
+
+/// @brief 弾が当たる長方形の標的（壁）
+struct RectTarget
+{
+	/// @brief 標的の P2BodyID
+	P2BodyID id;
+
+	/// @brief 標的の形
+	RectF rect;
+};
+
+/// @brief 動く円が標的に最初に触れる時刻と、そのときの法線
+struct SweepHit
+{
+	/// @brief 移動の始点を 0, 終点を 1 とした時刻
+	double t;
+
+	/// @brief 標的の表面の法線（標的の外向き）
+	Vec2 normal;
+};
+
+/// @brief 半径 radius の円が from から (from + delta) まで動くとき、円 circle に最初に触れる時刻を求めます。
+/// @return 触れる場合はその時刻と法線、触れない場合は none
+[[nodiscard]]
+inline Optional<SweepHit> SweepCircle(const Vec2& from, const Vec2& delta, double radius, const Circle& circle)
+{
+	// 半径の和の円と線分の交差を求める
+	const Vec2 m = (from - circle.center);
+	const double r = (circle.r + radius);
+	const double c = (m.lengthSq() - (r * r));
+
+	if (c <= 0.0) // 最初から重なっている
+	{
+		return SweepHit{ 0.0, (m.isZero() ? -delta.normalized() : m.normalized()) };
+	}
+
+	const double a = delta.lengthSq();
+	const double b = m.dot(delta);
+
+	if ((a == 0.0) || (0.0 <= b)) // 止まっているか、離れていく
+	{
+		return none;
+	}
+
+	const double discriminant = ((b * b) - (a * c));
+
+	if (discriminant < 0.0)
+	{
+		return none;
+	}
+
+	const double t = ((-b - std::sqrt(discriminant)) / a);
+
+	if (1.0 < t)
+	{
+		return none;
+	}
+
+	return SweepHit{ t, (m + delta * t).normalized() };
+}
+
+/// @brief 半径 radius の円が from から (from + delta) まで動くとき、長方形 rect に最初に触れる時刻を求めます。
+/// @return 触れる場合はその時刻と法線、触れない場合は none
+/// @remark 長方形を半径だけ広げた長方形と線分の交差を求めるので、角の近くでは実際よりわずかに早く触れたことになります。
+[[nodiscard]]
+inline Optional<SweepHit> SweepRect(const Vec2& from, const Vec2& delta, double radius, const RectF& rect)
+{
+	const RectF expanded = rect.stretched(radius);
+	const double mins[2] = { expanded.leftX(), expanded.topY() };
+	const double maxs[2] = { expanded.rightX(), expanded.bottomY() };
+	const double p[2] = { from.x, from.y };
+	const double d[2] = { delta.x, delta.y };
+
+	// 各軸のスラブに入る時刻の最大値と出る時刻の最小値
+	double tEnter = 0.0;
+	double tExit = 1.0;
+	Vec2 normal{ 0, 0 };
+
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		if (d[axis] == 0.0)
+		{
+			if ((p[axis] < mins[axis]) || (maxs[axis] < p[axis]))
+			{
+				return none;
+			}
+
+			continue;
+		}
+
+		double t0 = ((mins[axis] - p[axis]) / d[axis]);
+		double t1 = ((maxs[axis] - p[axis]) / d[axis]);
+		double sign = -1.0;
+
+		if (t1 < t0)
+		{
+			std::swap(t0, t1);
+			sign = 1.0;
+		}
+
+		if (tEnter < t0)
+		{
+			tEnter = t0;
+			normal = ((axis == 0) ? Vec2{ sign, 0 } : Vec2{ 0, sign });
+		}
+
+		tExit = Min(tExit, t1);
+
+		if (tExit < tEnter)
+		{
+			return none;
+		}
+	}
+
+	if (normal.isZero()) // 最初から重なっている
+	{
+		normal = -delta.normalized();
+	}
+
+	return SweepHit{ tEnter, normal };
+}
+
+/// @brief 円形の標的を一様グリッドに登録し、指定した領域と重なるセルの標的を列挙する空間ハッシュ
+/// @remark 標的は動くので、毎ステップ build() で作り直します。各セルの標的は計数ソートで 1 つの配列に詰めるので、
+/// 配列の容量が足りていれば作り直すときにメモリ確保は起こりません。グリッドの外にある標的や領域は、端のセルに含めます。
+class UniformGrid
+{
+public:
+
+	UniformGrid() = default;
+
+	/// @brief 空間ハッシュを作成します。
+	/// @param area グリッドで覆う範囲
+	/// @param cellSize セルの一辺の長さ
+	UniformGrid(const RectF& area, double cellSize)
+		: m_area{ area }
+		, m_cellSize{ cellSize }
+		, m_columns{ Max(static_cast<int32>(std::ceil(area.w / cellSize)), 1) }
+		, m_rows{ Max(static_cast<int32>(std::ceil(area.h / cellSize)), 1) }
+		, m_cellStarts((static_cast<size_t>(m_columns) * m_rows + 1), 0) {}
+
+	/// @brief 標的をグリッドに登録し直します。
+	/// @param targets 標的
+	void build(const Array<CircleTarget>& targets)
+	{
+		std::fill(m_cellStarts.begin(), m_cellStarts.end(), 0);
+
+		// 各セルに登録する標的の数を数える
+		for (const auto& target : targets)
+		{
+			forEachCell(target.circle.boundingRect(), [&](size_t cell) { ++m_cellStarts[cell + 1]; });
+		}
+
+		// 累積和を取って、各セルの先頭のインデックスにする
+		for (size_t i = 1; i < m_cellStarts.size(); ++i)
+		{
+			m_cellStarts[i] += m_cellStarts[i - 1];
+		}
+
+		m_items.resize(m_cellStarts.back());
+		m_cursors.assign(m_cellStarts.begin(), (m_cellStarts.end() - 1));
+
+		for (uint32 i = 0; i < targets.size(); ++i)
+		{
+			forEachCell(targets[i].circle.boundingRect(), [&](size_t cell) { m_items[m_cursors[cell]++] = i; });
+		}
+	}
+
+	/// @brief 指定した領域と重なるセルに登録されている標的のインデックスを列挙します。
+	/// @param region 領域
+	/// @param f 標的のインデックスを受け取る関数。複数のセルに登録されている標的は複数回渡されます
+	template <class Fty>
+	void query(const RectF& region, Fty f) const
+	{
+		forEachCell(region, [&](size_t cell)
+			{
+				for (uint32 i = m_cellStarts[cell]; i < m_cellStarts[cell + 1]; ++i)
+				{
+					f(m_items[i]);
+				}
+			});
+	}
+
+private:
+
+	RectF m_area{ 0, 0, 0, 0 };
+
+	double m_cellSize = 1.0;
+
+	int32 m_columns = 1;
+
+	int32 m_rows = 1;
+
+	// セル i の標的は m_items[m_cellStarts[i]] から m_items[m_cellStarts[i + 1] - 1] まで
+	Array<uint32> m_cellStarts = Array<uint32>(2, 0);
+
+	// セルごとに並べた標的のインデックス
+	Array<uint32> m_items;
+
+	// build() で各セルに次に書き込む位置
+	Array<uint32> m_cursors;
+
+	// 領域と重なるセルのインデックスを列挙する
+	template <class Fty>
+	void forEachCell(const RectF& region, Fty f) const
+	{
+		const int32 x0 = Clamp(static_cast<int32>(std::floor((region.leftX() - m_area.x) / m_cellSize)), 0, (m_columns - 1));
+		const int32 x1 = Clamp(static_cast<int32>(std::floor((region.rightX() - m_area.x) / m_cellSize)), 0, (m_columns - 1));
+		const int32 y0 = Clamp(static_cast<int32>(std::floor((region.topY() - m_area.y) / m_cellSize)), 0, (m_rows - 1));
+		const int32 y1 = Clamp(static_cast<int32>(std::floor((region.bottomY() - m_area.y) / m_cellSize)), 0, (m_rows - 1));
+
+		for (int32 y = y0; y <= y1; ++y)
+		{
+			for (int32 x = x0; x <= x1; ++x)
+			{
+				f(static_cast<size_t>(y) * m_columns + x);
+			}
+		}
+	}
+};
+
+/// @brief 動かない長方形の標的（壁）を登録し、動く円が触れる可能性のある標的を列挙する境界ボリューム階層 (BVH)
+/// @remark 標的は動かないので、作成時に一度だけ木を作ります。標的の中心が広がっている軸で標的を半分ずつに分けることを繰り返し、
+/// ノードは行きがけ順に 1 つの配列に詰めます（左の子は親の次のノード）。調べるときは、ノードの境界を円の半径だけ広げた長方形と移動の線分が交わる部分木だけをたどります。
+class StaticBVH
+{
+public:
+
+	StaticBVH() = default;
+
+	/// @brief 境界ボリューム階層を作成します。
+	/// @param targets 標的
+	explicit StaticBVH(const Array<RectTarget>& targets)
+		: m_targets{ targets }
+	{
+		if (not m_targets.isEmpty())
+		{
+			m_nodes.reserve(m_targets.size() * 2);
+			build(0, static_cast<uint32>(m_targets.size()));
+		}
+	}
+
+	/// @brief 登録した標的を返します。
+	/// @remark 標的の順番は、木を作るときに並べ替えたものです。
+	[[nodiscard]]
+	const Array<RectTarget>& targets() const noexcept
+	{
+		return m_targets;
+	}
+
+	/// @brief 半径 radius の円が from から (from + delta) まで動くときに触れる可能性のある標的を列挙します。
+	/// @param from 移動の始点
+	/// @param delta 移動量
+	/// @param radius 円の半径
+	/// @param f 標的を受け取る関数
+	template <class Fty>
+	void sweep(const Vec2& from, const Vec2& delta, double radius, Fty f) const
+	{
+		if (m_nodes.isEmpty())
+		{
+			return;
+		}
+
+		// 木の深さは標的の数の対数程度なので、固定長のスタックで足りる
+		std::array<uint32, 64> stack;
+		size_t stackSize = 0;
+		stack[stackSize++] = 0;
+
+		while (0 < stackSize)
+		{
+			const uint32 index = stack[--stackSize];
+			const Node& node = m_nodes[index];
+
+			if (not SweepRect(from, delta, radius, node.bounds))
+			{
+				continue;
+			}
+
+			if (node.count != 0)
+			{
+				for (uint32 i = node.first; i < (node.first + node.count); ++i)
+				{
+					f(m_targets[i]);
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.right;
+				stack[stackSize++] = (index + 1);
+			}
+		}
+	}
+
+private:
+
+	// 葉に入れる標的の最大数
+	static constexpr uint32 MaxLeafSize = 2;
+
+	struct Node
+	{
+		// 部分木のすべての標的を囲む長方形
+		RectF bounds;
+
+		// 葉の場合、最初の標的のインデックス
+		uint32 first;
+
+		// 葉の場合、標的の数（内部ノードの場合は 0）
+		uint32 count;
+
+		// 内部ノードの場合、右の子のインデックス
+		uint32 right;
+	};
+
+	// 標的（葉ごとに連続するように並べ替えたもの）
+	Array<RectTarget> m_targets;
+
+	Array<Node> m_nodes;
+
+	// [begin, end) の標的の部分木を作り、そのノードのインデックスを返す
+	uint32 build(uint32 begin, uint32 end)
+	{
+		const uint32 index = static_cast<uint32>(m_nodes.size());
+		m_nodes << Node{ boundsOf(begin, end), begin, (end - begin), 0 };
+
+		if ((end - begin) <= MaxLeafSize)
+		{
+			return index;
+		}
+
+		// 標的の中心の範囲が広い軸で、中央値を境に分ける
+		const RectF centerBounds = centerBoundsOf(begin, end);
+		const bool splitX = (centerBounds.h <= centerBounds.w);
+		const uint32 middle = ((begin + end) / 2);
+
+		std::nth_element((m_targets.begin() + begin), (m_targets.begin() + middle), (m_targets.begin() + end),
+			[splitX](const RectTarget& a, const RectTarget& b)
+			{
+				return (splitX ? (a.rect.centerX() < b.rect.centerX()) : (a.rect.centerY() < b.rect.centerY()));
+			});
+
+		build(begin, middle);
+		const uint32 right = build(middle, end);
+
+		Node& node = m_nodes[index];
+		node.count = 0;
+		node.right = right;
+		return index;
+	}
+
+	// [begin, end) の標的を囲む長方形を返す
+	[[nodiscard]]
+	RectF boundsOf(uint32 begin, uint32 end) const
+	{
+		double left = Math::Inf, top = Math::Inf, right = -Math::Inf, bottom = -Math::Inf;
+
+		for (uint32 i = begin; i < end; ++i)
+		{
+			const RectF& rect = m_targets[i].rect;
+			left = Min(left, rect.leftX());
+			top = Min(top, rect.topY());
+			right = Max(right, rect.rightX());
+			bottom = Max(bottom, rect.bottomY());
+		}
+
+		return RectF{ left, top, (right - left), (bottom - top) };
+	}
+
+	// [begin, end) の標的の中心を囲む長方形を返す
+	[[nodiscard]]
+	RectF centerBoundsOf(uint32 begin, uint32 end) const
+	{
+		double left = Math::Inf, top = Math::Inf, right = -Math::Inf, bottom = -Math::Inf;
+
+		for (uint32 i = begin; i < end; ++i)
+		{
+			const Vec2 center = m_targets[i].rect.center();
+			left = Min(left, center.x);
+			top = Min(top, center.y);
+			right = Max(right, center.x);
+			bottom = Max(bottom, center.y);
+		}
+
+		return RectF{ left, top, (right - left), (bottom - top) };
+	}
+};
+
+/// @brief 動く円が最初に触れる標的
+struct TargetHit
+{
+	/// @brief 標的の P2BodyID
+	P2BodyID id;
+
+	/// @brief 触れる時刻と法線
+	SweepHit hit;
+};
+
+/// @brief 半径 radius の円が from から (from + delta) まで動くとき、最初に触れる壁または標的を探します。
+/// @param from 移動の始点
+/// @param delta 移動量
+/// @param radius 円の半径
+/// @param walls 壁を登録した境界ボリューム階層
+/// @param targets 標的
+/// @param grid 標的を登録した空間ハッシュ
+/// @return 触れる場合は最初に触れる壁または標的、触れない場合は none
+[[nodiscard]]
+inline Optional<TargetHit> FindFirstHit(const Vec2& from, const Vec2& delta, double radius, const StaticBVH& walls, const Array<CircleTarget>& targets, const UniformGrid& grid)
+{
+	Optional<TargetHit> result;
+
+	walls.sweep(from, delta, radius, [&](const RectTarget& wall)
+		{
+			if (const auto hit = SweepRect(from, delta, radius, wall.rect);
+				hit && ((not result) || (hit->t < result->hit.t)))
+			{
+				result = TargetHit{ wall.id, *hit };
+			}
+		});
+
+	// 移動範囲を円の半径だけ広げた領域と重なるセルの標的だけを調べる
+	const RectF region = RectF{ Min(from.x, (from.x + delta.x)), Min(from.y, (from.y + delta.y)), Abs(delta.x), Abs(delta.y) }.stretched(radius);
+
+	grid.query(region, [&](uint32 index)
+		{
+			const CircleTarget& target = targets[index];
+
+			if (const auto hit = SweepCircle(from, delta, radius, target.circle);
+				hit && ((not result) || (hit->t < result->hit.t)))
+			{
+				result = TargetHit{ target.id, *hit };
+			}
+		});
+
+	return result;
+}
+
+/// @brief 弾と標的の間の摩擦係数（P2Material の既定値どうしの組み合わせ）
+constexpr double BulletFriction = 0.2;
+
+/// @brief 動く弾が標的に当たったときの衝突イベントを作ります。
+/// @param hit 当たった標的と、当たった時刻・法線
+/// @param bulletID 弾の P2BodyID
+/// @param from 移動の始点
+/// @param delta 移動量
+/// @param velocity 弾の速度
+/// @param mass 弾の質量
+/// @param timestamp 現在のゲーム時刻
+/// @return 衝突イベント
+/// @remark 弾は止まり（反発係数 0）、標的は動かないものとして、物理演算エンジンが弾を止めるときと同じ大きさの力を求めます。
+[[nodiscard]]
+inline CollisionEvent MakeSweepCollisionEvent(const TargetHit& hit, P2BodyID bulletID, const Vec2& from, const Vec2& delta, const Vec2& velocity, double mass, TimestampSec timestamp)
+{
+	const Vec2 pos = (from + delta * hit.hit.t);
+	const double normalSpeed = -velocity.dot(hit.hit.normal);
+	const double tangentSpeed = Abs(velocity.dot(Vec2{ -hit.hit.normal.y, hit.hit.normal.x }));
+	const double normalImpulse = (mass * Max(normalSpeed, 0.0));
+
+	return CollisionEvent
+	{
+		.a = hit.id,
+		.b = bulletID,
+		.pos = (pos - hit.hit.normal * BulletRadius),
+		.normalImpulse = normalImpulse,
+		.tangentImpulse = Min((BulletFriction * normalImpulse), (mass * tangentSpeed)),
+		.timestamp = timestamp
+	};
+}
@@ -0,0 +1,54 @@
+# pragma once
+# include <Siv3D.hpp>
+
+/// @brief タイムスタンプ（秒）を表現する型
+using TimestampSec = double;
+
+/// @brief 「壁」の干渉フィルタ
+constexpr P2Filter WallFilter{ .categoryBits = 0b0000'0000'0000'0001, .maskBits = 0b1111'1111'1111'1111 };
+
+/// @brief 「味方の弾」の干渉フィルタ（味方の弾、味方ユニットとは干渉しない）
+constexpr P2Filter FriendBulletFilter{ .categoryBits = 0b0000'0000'0000'0010, .maskBits = 0b1111'1111'1111'1001 };
+
+/// @brief 「味方ユニット」の干渉フィルタ（味方ユニット、敵ユニットとは干渉しない）
+constexpr P2Filter FriendUnitFilter{ .categoryBits = 0b0000'0000'0000'0100, .maskBits = 0b1111'1111'1111'0011 };
+
+/// @brief 「敵ユニット」の干渉フィルタ（味方ユニット、敵ユニットとは干渉しない）
+constexpr P2Filter EnemyUnitFilter{ .categoryBits = 0b0000'0000'0000'1000, .maskBits = 0b1111'1111'1111'0011 };
+
+/// @brief 弾の半径
+constexpr double BulletRadius = 5.0;
+
+/// @brief 弾の空気抵抗の強さ
+constexpr double BulletAirResistance = 0.002;
+
+/// @brief P2Body を持たない軽量な弾を、衝突イベントで表す P2BodyID
+constexpr P2BodyID LightBulletID = Largest<P2BodyID>;
+
+[[nodiscard]]
+constexpr int32 ImpulseToDamage(double impulse)
+{
+	return static_cast<int32>(impulse * 100);
+}
+
+/// @brief 衝突イベント
+struct CollisionEvent
+{
+	/// @brief 衝突した物体の P2BodyID
+	P2BodyID a;
+
+	/// @brief 衝突した物体の P2BodyID
+	P2BodyID b;
+
+	/// @brief 衝突位置
+	Vec2 pos;
+
+	/// @brief 衝突時の法線方向の力
+	double normalImpulse = 0.0;
+
+	/// @brief 衝突時の接線方向の力
+	double tangentImpulse = 0.0;
+
+	/// @brief 衝突が発生したタイムスタンプ
+	TimestampSec timestamp;
+};
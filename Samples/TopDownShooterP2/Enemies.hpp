@@ -0,0 +1,237 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Common.hpp"
+# include "Snapshot.hpp"
+
+/// @brief 敵ユニット
+struct Enemy
+{
+	static constexpr double Radius = 40.0;
+
+	P2Body body;
+
+	int32 hp;
+
+	int32 maxHP;
+
+	bool move;
+
+	void draw(const Font& font) const
+	{
+		const Vec2 pos = body.getPos();
+
+		Circle{ pos, Radius }.draw(Palette::Magenta);
+
+		font(U"{}/{}"_fmt(hp, maxHP)).drawAt(14, pos);
+	}
+};
+
+/// @brief すべての敵ユニットの管理クラス
+/// @remark 敵ユニットは密な配列に詰めて持ち、P2BodyID から配列のインデックスを引く表を別に持ちます。
+/// 衝突イベントによるダメージは、1 回の走査で敵ユニットのインデックスごとに合計してから HP に反映し、HP が 0 になった敵ユニットは最後の敵ユニットとの入れ替え (swap-and-pop) で削除します。
+class EnemyList
+{
+public:
+
+	/// @brief 敵ユニットを追加する
+	/// @param enemy 敵ユニット
+	void add(Enemy enemy)
+	{
+		m_indices.emplace(enemy.body.id(), m_enemies.size());
+		m_enemies << std::move(enemy);
+		m_damages << 0;
+	}
+
+	/// @brief 衝突イベントによるダメージを与え、HP が 0 になった敵ユニットを削除する
+	/// @param events 衝突イベント
+	/// @return 削除した敵ユニットの数
+	size_t applyDamage(const Array<CollisionEvent>& events)
+	{
+		// 敵ユニットごとにダメージを合計する
+		for (const auto& event : events)
+		{
+			accumulate(event.a, event.normalImpulse);
+			accumulate(event.b, event.normalImpulse);
+		}
+
+		// 後ろのインデックスから処理すれば、削除で空いた場所に移ってくるのは処理済みの生き残りだけになる
+		std::sort(m_damagedIndices.begin(), m_damagedIndices.end(), std::greater<>{});
+
+		size_t removedCount = 0;
+
+		for (const size_t index : m_damagedIndices)
+		{
+			Enemy& enemy = m_enemies[index];
+			enemy.hp = Max((enemy.hp - m_damages[index]), 0);
+			m_damages[index] = 0;
+
+			if (enemy.hp <= 0)
+			{
+				remove(index);
+				++removedCount;
+			}
+		}
+
+		m_damagedIndices.clear();
+
+		return removedCount;
+	}
+
+	/// @brief 敵ユニットの状態を書き込む
+	/// @param writer 書き込み先
+	/// @remark P2BodyID は書き込まず、P2Body は並び順で区別します。
+	void save(StateWriter& writer) const
+	{
+		writer.write(static_cast<uint64>(m_enemies.size()));
+
+		for (const auto& enemy : m_enemies)
+		{
+			writer.write(enemy.body.getPos());
+			writer.write(enemy.body.getAngle());
+			writer.write(enemy.body.getVelocity());
+			writer.write(enemy.body.getAngularVelocity());
+			writer.write(enemy.hp);
+			writer.write(enemy.maxHP);
+			writer.write(enemy.move);
+		}
+	}
+
+	/// @brief すべての敵ユニットを、その P2Body とともに削除する
+	void clear()
+	{
+		m_enemies.clear();
+		m_indices.clear();
+		m_damages.clear();
+		m_damagedIndices.clear();
+	}
+
+	/// @brief 敵ユニットの状態を読み込む
+	/// @param reader 読み込み元
+	/// @param world 物理演算ワールド
+	/// @return 読み込めた場合 true, それ以外の場合は false
+	/// @remark 今いる敵ユニットを削除してから、保存したときの並び順で P2Body を作り直し、位置・角度・速度・角速度を保存したときの値に戻します。
+	[[nodiscard]]
+	bool load(StateReader& reader, P2World& world)
+	{
+		clear();
+
+		uint64 count;
+
+		if (not reader.read(count))
+		{
+			return false;
+		}
+
+		for (uint64 i = 0; i < count; ++i)
+		{
+			Vec2 pos, velocity;
+			double angle, angularVelocity;
+			int32 hp, maxHP;
+			bool move;
+
+			if ((not reader.read(pos)) || (not reader.read(angle)) || (not reader.read(velocity)) || (not reader.read(angularVelocity))
+				|| (not reader.read(hp)) || (not reader.read(maxHP)) || (not reader.read(move)))
+			{
+				return false;
+			}
+
+			P2Body body = world.createCircle(P2Kinematic, pos, Enemy::Radius, {}, EnemyUnitFilter);
+			body.setAngle(angle);
+			body.setVelocity(velocity);
+			body.setAngularVelocity(angularVelocity);
+
+			add(Enemy{ std::move(body), hp, maxHP, move });
+		}
+
+		return true;
+	}
+
+	/// @brief 敵ユニットの数を返す
+	[[nodiscard]]
+	size_t size() const noexcept
+	{
+		return m_enemies.size();
+	}
+
+	[[nodiscard]]
+	auto begin() noexcept
+	{
+		return m_enemies.begin();
+	}
+
+	[[nodiscard]]
+	auto end() noexcept
+	{
+		return m_enemies.end();
+	}
+
+	[[nodiscard]]
+	auto begin() const noexcept
+	{
+		return m_enemies.begin();
+	}
+
+	[[nodiscard]]
+	auto end() const noexcept
+	{
+		return m_enemies.end();
+	}
+
+private:
+
+	// 敵ユニット
+	Array<Enemy> m_enemies;
+
+	// 敵ユニットの P2BodyID → m_enemies のインデックス
+	HashTable<P2BodyID, size_t> m_indices;
+
+	// 敵ユニットごとの、反映前のダメージの合計（m_enemies と同じ並び）
+	Array<int32> m_damages;
+
+	// このフレームでダメージを受けた敵ユニットのインデックス
+	Array<size_t> m_damagedIndices;
+
+	// 指定した P2Body が敵ユニットであれば、ダメージを加算する
+	void accumulate(P2BodyID id, double normalImpulse)
+	{
+		const auto it = m_indices.find(id);
+
+		if (it == m_indices.end())
+		{
+			return;
+		}
+
+		// 衝突ごとにダメージに変換してから合計する（1 回ずつ HP を減らす場合と同じ結果になる）
+		const int32 damage = ImpulseToDamage(normalImpulse);
+
+		if (damage <= 0)
+		{
+			return;
+		}
+
+		const size_t index = it->second;
+
+		if (m_damages[index] == 0)
+		{
+			m_damagedIndices << index;
+		}
+
+		m_damages[index] += damage;
+	}
+
+	// 指定したインデックスの敵ユニットを、最後の敵ユニットと入れ替えて削除する
+	void remove(size_t index)
+	{
+		m_indices.erase(m_enemies[index].body.id());
+
+		if (index != (m_enemies.size() - 1))
+		{
+			m_enemies[index] = std::move(m_enemies.back());
+			m_damages[index] = m_damages.back();
+			m_indices[m_enemies[index].body.id()] = index;
+		}
+
+		m_enemies.pop_back();
+		m_damages.pop_back();
+	}
+};
@@ -0,0 +1,240 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Collision.hpp"
+# include "Common.hpp"
+# include "Snapshot.hpp"
+
+/// @brief P2Body を使わない軽量な弾の管理クラス
+/// @remark 弾の位置・速度・密度・発射時刻を、それぞれ別の連続した配列 (SoA) に持ちます。空気抵抗と移動は自前で積分し、
+/// 1 ステップの移動の始点から終点までを掃引した円と、空間ハッシュで絞り込んだ敵ユニット、および境界ボリューム階層で絞り込んだ壁との衝突を調べます。
+/// 物理演算ワールドに物体を作らないので、弾の数が多くてもブロードフェーズや接触の処理のコストがかかりません。
+/// 当たった弾は止まり（反発係数 0）、標的は動かないものとして、P2Body の弾と同じ大きさの力を衝突イベントとして報告します。
+class LightBulletList
+{
+public:
+
+	LightBulletList() = default;
+
+	/// @brief 軽量な弾の管理クラスを作成します。
+	/// @param massPerDensity 密度 1 の弾の質量（P2Body の弾と同じ威力になるように、P2Body の弾の質量を渡します）
+	explicit LightBulletList(double massPerDensity)
+		: m_massPerDensity{ massPerDensity } {}
+
+	/// @brief 弾を発射する
+	/// @param from 発射位置
+	/// @param velocity 発射速度
+	/// @param density 弾の密度 (kg / m^2)
+	/// @param timestamp 発射時刻
+	void fire(const Vec2& from, const Vec2& velocity, double density, TimestampSec timestamp)
+	{
+		m_xs << from.x;
+		m_ys << from.y;
+		m_vxs << velocity.x;
+		m_vys << velocity.y;
+		m_densities << density;
+		m_timestamps << timestamp;
+	}
+
+	/// @brief 指定した個数の弾を持てるように、配列の容量を確保しておく
+	/// @param count 個数
+	void reserve(size_t count)
+	{
+		m_xs.reserve(count);
+		m_ys.reserve(count);
+		m_vxs.reserve(count);
+		m_vys.reserve(count);
+		m_densities.reserve(count);
+		m_timestamps.reserve(count);
+	}
+
+	/// @brief すべての弾に空気抵抗を与えて 1 ステップ分動かし、領域外の弾、期限切れの弾、壁や標的に当たった弾を削除して、当たった弾の衝突イベントを追加する
+	/// @param dt タイムステップ
+	/// @param bounds 領域（この外に出た弾を削除する）
+	/// @param expiry タイムスタンプ（これより前に発射された弾を削除する）
+	/// @param walls 壁を登録した境界ボリューム階層
+	/// @param targets 標的
+	/// @param grid 標的を登録した空間ハッシュ
+	/// @param timestamp 現在のゲーム時刻
+	/// @param events 衝突イベントの追加先
+	/// @remark 空気抵抗・移動・領域外と期限切れの判定・衝突判定・削除を、配列を 1 回走査するだけでまとめて行います。
+	/// 配列は BlockSize 個ずつに区切り、ブロックごとにまず分岐のないループで空気抵抗・移動と残すかどうかを計算して（コンパイラが SIMD 命令にできる形。
+	/// 特定の命令セットに依存しないので Web 版でも同じコードが使えます）、そのブロックがキャッシュにあるうちに、残る弾についてだけ衝突を調べて前に詰めます。
+	void update(double dt, const RectF& bounds, TimestampSec expiry, const StaticBVH& walls, const Array<CircleTarget>& targets, const UniformGrid& grid, TimestampSec timestamp, Array<CollisionEvent>& events)
+	{
+		double* xs = m_xs.data();
+		double* ys = m_ys.data();
+		double* vxs = m_vxs.data();
+		double* vys = m_vys.data();
+		const double* densities = m_densities.data();
+		const TimestampSec* timestamps = m_timestamps.data();
+
+		// P2Body の弾と同じく、速さに比例した空気抵抗の力積を与えてから位置を進める（速度に掛ける値は 1 - dragPerDensity / 密度）
+		const double dragPerDensity = (dt * BulletAirResistance / m_massPerDensity);
+		const double left = bounds.leftX(), right = bounds.rightX(), top = bounds.topY(), bottom = bounds.bottomY();
+
+		// ブロック内の各弾が、領域内にあって期限切れでないか
+		std::array<uint8, BlockSize> alive;
+
+		// 残す弾を前に詰める（書き込み先は常に読み込み済みの位置なので、後のブロックを上書きしない）
+		size_t count = 0;
+
+		for (size_t begin = 0; begin < m_xs.size(); begin += BlockSize)
+		{
+			const size_t n = Min(BlockSize, (m_xs.size() - begin));
+
+			for (size_t k = 0; k < n; ++k)
+			{
+				const size_t i = (begin + k);
+				const double damping = (1.0 - (dragPerDensity / densities[i]));
+				const double vx = (vxs[i] * damping);
+				const double vy = (vys[i] * damping);
+				const double x = (xs[i] + vx * dt);
+				const double y = (ys[i] + vy * dt);
+
+				vxs[i] = vx;
+				vys[i] = vy;
+				xs[i] = x;
+				ys[i] = y;
+			}
+
+			// 型の異なる配列への書き込みを混ぜるとベクトル化されにくいので、判定は別のループにする
+			for (size_t k = 0; k < n; ++k)
+			{
+				const size_t i = (begin + k);
+				const double x = xs[i];
+				const double y = ys[i];
+				alive[k] = static_cast<uint8>((expiry <= timestamps[i]) & (left <= x) & (x <= right) & (top <= y) & (y <= bottom));
+			}
+
+			for (size_t k = 0; k < n; ++k)
+			{
+				if (not alive[k])
+				{
+					continue;
+				}
+
+				const size_t i = (begin + k);
+				const Vec2 velocity{ vxs[i], vys[i] };
+				const Vec2 delta = (velocity * dt);
+				const Vec2 from = (Vec2{ xs[i], ys[i] } - delta);
+
+				if (const auto hit = FindFirstHit(from, delta, BulletRadius, walls, targets, grid))
+				{
+					events << MakeSweepCollisionEvent(*hit, LightBulletID, from, delta, velocity, (m_massPerDensity * densities[i]), timestamp);
+					continue;
+				}
+
+				if (i != count)
+				{
+					xs[count] = xs[i];
+					ys[count] = ys[i];
+					vxs[count] = vxs[i];
+					vys[count] = vys[i];
+					m_densities[count] = densities[i];
+					m_timestamps[count] = timestamps[i];
+				}
+
+				++count;
+			}
+		}
+
+		resize(count);
+	}
+
+	/// @brief すべての弾を描画する
+	void draw() const
+	{
+		for (size_t i = 0; i < m_xs.size(); ++i)
+		{
+			const Vec2 pos{ m_xs[i], m_ys[i] };
+
+			Circle{ pos, BulletRadius }.draw(Palette::Skyblue);
+
+			if (5.0 <= m_densities[i])
+			{
+				Circle{ pos, 8 }.drawFrame(1, Palette::Skyblue);
+			}
+		}
+	}
+
+	/// @brief 弾の個数を返す
+	[[nodiscard]]
+	size_t size() const noexcept
+	{
+		return m_xs.size();
+	}
+
+	/// @brief 弾が 1 つも無いかを返す
+	[[nodiscard]]
+	bool isEmpty() const noexcept
+	{
+		return m_xs.isEmpty();
+	}
+
+	/// @brief 弾の状態を書き込む
+	/// @param writer 書き込み先
+	void save(StateWriter& writer) const
+	{
+		writer.writeArray(m_xs);
+		writer.writeArray(m_ys);
+		writer.writeArray(m_vxs);
+		writer.writeArray(m_vys);
+		writer.writeArray(m_densities);
+		writer.writeArray(m_timestamps);
+	}
+
+	/// @brief 弾の状態を読み込む
+	/// @param reader 読み込み元
+	/// @return 読み込めた場合 true, それ以外の場合は false
+	[[nodiscard]]
+	bool load(StateReader& reader)
+	{
+		if ((not reader.readArray(m_xs)) || (not reader.readArray(m_ys)) || (not reader.readArray(m_vxs))
+			|| (not reader.readArray(m_vys)) || (not reader.readArray(m_densities)) || (not reader.readArray(m_timestamps)))
+		{
+			return false;
+		}
+
+		const size_t count = m_xs.size();
+		return ((m_ys.size() == count) && (m_vxs.size() == count) && (m_vys.size() == count)
+			&& (m_densities.size() == count) && (m_timestamps.size() == count));
+	}
+
+	/// @brief 状態を Print する
+	void showStats() const
+	{
+		Print << U"light bullets: {}"_fmt(m_xs.size());
+	}
+
+private:
+
+	// update() でまとめて処理する弾の数（ブロックの配列がすべて L1 キャッシュに収まる大きさ）
+	static constexpr size_t BlockSize = 256;
+
+	// 密度 1 の弾の質量
+	double m_massPerDensity = 1.0;
+
+	Array<double> m_xs;
+
+	Array<double> m_ys;
+
+	Array<double> m_vxs;
+
+	Array<double> m_vys;
+
+	Array<double> m_densities;
+
+	// 発射時刻
+	Array<TimestampSec> m_timestamps;
+
+	void resize(size_t count)
+	{
+		m_xs.resize(count);
+		m_ys.resize(count);
+		m_vxs.resize(count);
+		m_vys.resize(count);
+		m_densities.resize(count);
+		m_timestamps.resize(count);
+	}
+
+};
@@ -1,294 +1,363 @@
 # include <Siv3D.hpp> // OpenSiv3D v0.6.5
+# include "AllocationCounter.hpp"
+# include "Benchmark.hpp"
+# include "Common.hpp"
+# include "Rollback.hpp"
+# include "Simulation.hpp"
+# include "StressTest.hpp"
 
-/// @brief タイムスタンプ（秒）を表現する型
-using TimestampSec = double;
+# if defined(TOPDOWNSHOOTER_BENCHMARK) || defined(TOPDOWNSHOOTER_STRESS)
 
-/// @brief 「壁」の干渉フィルタ
-constexpr P2Filter WallFilter{ .categoryBits = 0b0000'0000'0000'0001, .maskBits = 0b1111'1111'1111'1111 };
+// TOPDOWNSHOOTER_BENCHMARK を定義してビルドすると、ウィンドウを作らずにベンチマークだけを実行する
+// TOPDOWNSHOOTER_STRESS を定義してビルドすると、ウィンドウを作らずにストレステストだけを実行する
+SIV3D_SET(EngineOption::Renderer::Headless)
 
-/// @brief 「味方の弾」の干渉フィルタ（味方の弾、味方ユニットとは干渉しない）
-constexpr P2Filter FriendBulletFilter{ .categoryBits = 0b0000'0000'0000'0010, .maskBits = 0b1111'1111'1111'1001 };
+# endif
 
-/// @brief 「味方ユニット」の干渉フィルタ（味方ユニット、敵ユニットとは干渉しない）
-constexpr P2Filter FriendUnitFilter{ .categoryBits = 0b0000'0000'0000'0100, .maskBits = 0b1111'1111'1111'0011 };
+# if defined(TOPDOWNSHOOTER_COUNT_ALLOCATIONS)
 
-/// @brief 「敵ユニット」の干渉フィルタ（味方ユニット、敵ユニットとは干渉しない）
-constexpr P2Filter EnemyUnitFilter{ .categoryBits = 0b0000'0000'0000'1000, .maskBits = 0b1111'1111'1111'0011 };
+// TOPDOWNSHOOTER_COUNT_ALLOCATIONS を定義してビルドすると、メモリ確保の回数を数えるために、グローバルな operator new と operator delete を置き換える
+// （配列版は既定でこれらを呼ぶ。nothrow 版も既定では通常版を呼ぶが、実装によらず数えられるように置き換える）
+namespace AllocationCounter::detail
+{
+	[[nodiscard]]
+	inline void* Allocate(std::size_t size) noexcept
+	{
+		Increment();
+		return std::malloc(size ? size : 1);
+	}
+
+	[[nodiscard]]
+	inline void* AllocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		Increment();
+
+		const std::size_t align = static_cast<std::size_t>(alignment);
+	# if SIV3D_PLATFORM(WINDOWS)
+		return _aligned_malloc((size ? size : 1), align);
+	# else
+		// aligned_alloc() に渡す大きさはアライメントの倍数でなければならない
+		return std::aligned_alloc(align, ((Max<std::size_t>(size, 1) + align - 1) / align * align));
+	# endif
+	}
 
-[[nodiscard]]
-constexpr int32 ImpulseToDamage(double impulse)
+	inline void FreeAligned(void* p) noexcept
+	{
+	# if SIV3D_PLATFORM(WINDOWS)
+		_aligned_free(p);
+	# else
+		std::free(p);
+	# endif
+	}
+}
+
+void* operator new(std::size_t size)
 {
-	return static_cast<int32>(impulse * 100);
+	if (void* p = AllocationCounter::detail::Allocate(size))
+	{
+		return p;
+	}
+
+	throw std::bad_alloc{};
 }
 
-/// @brief 衝突イベント
-struct CollisionEvent
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
 {
-	/// @brief 衝突した物体の P2BodyID
-	P2BodyID a;
+	return AllocationCounter::detail::Allocate(size);
+}
 
-	/// @brief 衝突した物体の P2BodyID
-	P2BodyID b;
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* p = AllocationCounter::detail::AllocateAligned(size, alignment))
+	{
+		return p;
+	}
 
-	/// @brief 衝突位置
-	Vec2 pos;
+	throw std::bad_alloc{};
+}
 
-	/// @brief 衝突時の法線方向の力
-	double normalImpulse = 0.0;
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocationCounter::detail::AllocateAligned(size, alignment);
+}
 
-	/// @brief 衝突時の接線方向の力
-	double tangentImpulse = 0.0;
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
 
-	/// @brief 衝突が発生したタイムスタンプ
-	TimestampSec timestamp;
-};
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	AllocationCounter::detail::FreeAligned(p);
+}
 
-/// @brief 敵ユニット
-struct Enemy
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
 {
-	static constexpr double Radius = 40.0;
+	AllocationCounter::detail::FreeAligned(p);
+}
 
-	P2Body body;
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	AllocationCounter::detail::FreeAligned(p);
+}
 
-	int32 hp;
+# endif
 
-	int32 maxHP;
+/// @brief 衝突エフェクト（大きくなる輪と、ダメージの数値）の管理クラス
+/// @remark エフェクトごとにオブジェクトを確保する Effect の代わりに、すべてのエフェクトの状態を 1 つの配列に持ちます。
+/// 終わったエフェクトは詰めて削除し、配列の容量は減らさないので、同時に表示するエフェクトの数が一度最大に達した後は、エフェクトを追加してもメモリ確保が起こりません。
+class RingEffectPool
+{
+public:
 
-	bool move;
+	RingEffectPool() = default;
 
-	void damage(double normalImpulse)
+	/// @brief 衝突エフェクトの管理クラスを作成します。
+	/// @param capacity 最初に容量を確保しておくエフェクトの数
+	explicit RingEffectPool(size_t capacity)
 	{
-		hp = Max((hp - ImpulseToDamage(normalImpulse)), 0);
+		m_rings.reserve(capacity);
 	}
 
-	void draw(const Font& font)
+	/// @brief エフェクトを追加する
+	/// @param pos 位置
+	/// @param normalImpulse 衝突時の法線方向の力
+	void add(const Vec2& pos, double normalImpulse)
 	{
-		const Vec2 pos = body.getPos();
+		m_rings << Ring{ pos, normalImpulse, RandomColorF(), 0.0 };
+	}
 
-		Circle{ pos, Radius }.draw(Palette::Magenta);
+	/// @brief すべてのエフェクトを描画して時間を進め、終わったエフェクトを削除する
+	/// @param font ダメージの数値のフォント
+	void update(const Font& font)
+	{
+		const double deltaTime = Scene::DeltaTime();
 
-		font(U"{}/{}"_fmt(hp, maxHP)).drawAt(14, pos);
-	}
-};
+		size_t count = 0;
 
-/// @brief 衝突エフェクトクラス
-struct RingEffect : IEffect
-{
-	Vec2 m_pos;
+		for (auto& ring : m_rings)
+		{
+			const double t = ring.time;
 
-	double m_normalImpulse;
+			// 時間に応じて大きくなる輪
+			Circle{ ring.pos, (15 + t * 80) }.drawFrame(12 * (Duration - t), ring.color);
 
-	ColorF m_color;
+			font(ImpulseToDamage(ring.normalImpulse))
+				.drawAt(TextStyle::Outline(0.2, ColorF{ 0.1, (1.0 - t * 2) }), ring.pos + Vec2{ 20, -20 - t * 120 }, ColorF{ 1.0, (1.0 - t * 2) });
 
-	explicit RingEffect(const Vec2& pos, double normalImpulse)
-		: m_pos{ pos }
-		, m_normalImpulse{ normalImpulse }
-		, m_color{ RandomColorF() } {}
+			ring.time += deltaTime;
 
-	bool update(double t) override
-	{
-		// 時間に応じて大きくなる輪
-		Circle{ m_pos, (15 + t * 80) }.drawFrame(12 * (0.5 - t), m_color);
+			// 0.5 秒未満なら継続
+			if (ring.time < Duration)
+			{
+				m_rings[count++] = ring;
+			}
+		}
 
-		FontAsset(U"BoldFont")(ImpulseToDamage(m_normalImpulse))
-			.drawAt(TextStyle::Outline(0.2, ColorF{ 0.1, (1.0 - t * 2) }), m_pos + Vec2{ 20, -20 - t * 120 }, ColorF{ 1.0, (1.0 - t * 2) });
+		m_rings.resize(count);
+	}
 
-		// 0.5 秒未満なら継続
-		return (t < 0.5);
+	/// @brief 表示中のエフェクトの数を返す
+	[[nodiscard]]
+	size_t size() const noexcept
+	{
+		return m_rings.size();
 	}
+
+private:
+
+	// エフェクトの長さ（秒）
+	static constexpr double Duration = 0.5;
+
+	struct Ring
+	{
+		Vec2 pos;
+
+		double normalImpulse;
+
+		ColorF color;
+
+		// 経過時間（秒）
+		double time;
+	};
+
+	Array<Ring> m_rings;
 };
 
-/// @brief すべての弾の管理クラス
-class BulletList
+// P2Body の弾と軽量な弾の処理の速さを弾の数を変えながら比べ、ロールバックにかかる時間を通信の遅延を変えながら計測し、1 ステップの処理の並列化の効果を計測し、状態の復元が決定的かを確かめて、コンソールに出力する関数
+void RunBenchmarks()
 {
-public:
+	const Array<BulletBenchmarkConfig> configs =
+	{
+		{ .bulletCount = 1'000 },
+		{ .bulletCount = 10'000 },
+		{ .bulletCount = 100'000, .stepCount = 20 },
+	};
 
-	/// @brief 弾を発射する
-	/// @param world 物理演算ワールド
-	/// @param from 発射位置
-	/// @param velocity 発射速度
-	/// @param density 弾の密度 (kg / m^2)
-	/// @param timeStamp 発射時刻
-	void fire(P2World& world, const Vec2& from, const Vec2& velocity, double density, TimestampSec timestamp)
+	Console << U"bullets, steps, P2Body [ms/step], light [ms/step], speedup, P2Body hits, light hits";
+
+	for (const auto& config : configs)
 	{
-		P2Body body = world.createCircle(P2Dynamic, from, 5, P2Material{ .density = density }, FriendBulletFilter).setVelocity(velocity);
-		// body.setBullet(true); // 高速な弾のすり抜けを防止できる (OpenSiv3D v0.6.6 以降）
-		m_bullets << body;
-		m_bulletSet.emplace(body.id(), timestamp);
+		const BulletBenchmarkResult result = RunBulletBenchmark(config);
+
+		Console << U"{}, {}, {:.3f}, {:.3f}, {:.1f}, {}, {}"_fmt(config.bulletCount, config.stepCount,
+			result.physicsMillisec, result.lightMillisec, (result.physicsMillisec / result.lightMillisec), result.physicsHitCount, result.lightHitCount);
 	}
 
-	/// @brief すべての弾に空気抵抗相当の力を与える
-	/// @param dt タイムステップ
-	void applyAirResistance(double dt)
+	const Array<RollbackBenchmarkConfig> rollbackConfigs =
 	{
-		for (auto& bullet : m_bullets)
-		{
-			// 速さに比例した空気抵抗
-			bullet.applyLinearImpulse(-bullet.getVelocity() * dt * AirResistance);
-		}
-	}
+		{ .latencySec = 0.0, .jitterSec = 0.0 },
+		{ .latencySec = 0.05, .jitterSec = 0.01 },
+		{ .latencySec = 0.1, .jitterSec = 0.02 },
+		{ .latencySec = 0.2, .jitterSec = 0.04 },
+	};
 
-	/// @brief 指定した P2BodyID の弾を削除する
-	/// @param id 削除する弾の P2BodyID
-	void remove(P2BodyID id)
+	Console << U"latency [ms], jitter [ms], steps, step [ms], rollbacks, resimulated steps, max resimulated steps, resimulation [ms/step], stalls, checked states, desyncs, resyncs, halts, consistent";
+
+	for (const auto& config : rollbackConfigs)
 	{
-		if (not m_bulletSet.contains(id))
-		{
-			return;
-		}
+		const RollbackBenchmarkResult result = RunRollbackBenchmark(config);
+		const RollbackStats& stats = result.stats;
+
+		Console << U"{:.0f}, {:.0f}, {}, {:.3f}, {}, {}, {}, {:.3f}, {}, {}, {}, {}, {}, {}"_fmt((config.latencySec * 1000), (config.jitterSec * 1000), config.stepCount,
+			result.millisecPerStep, stats.rollbackCount, stats.resimulatedSteps, stats.maxResimulatedSteps, stats.millisecPerResimulatedStep(), stats.stallCount,
+			stats.checkedStateCount, stats.desyncCount, stats.resyncCount, stats.haltCount, result.consistent);
 
-		for (auto it = m_bullets.begin(); it != m_bullets.end(); ++it)
+		if (not result.consistent)
 		{
-			if (it->id() == id)
-			{
-				m_bulletSet.erase(id);
-				m_bullets.erase(it);
-				break;
-			}
+			Console << U"sessions differ after all inputs arrived at latency {:.0f} ms"_fmt(config.latencySec * 1000);
 		}
 	}
 
-	/// @brief 指定した領域外の弾を削除する
-	/// @param bounds 領域
-	void removeOutOfBounds(const RectF& bounds)
+	WorkerPool workerPool{ (Max(Threading::GetConcurrency(), size_t{ 1 }) - 1) };
+
+	Console << U"threads, steps, bullets, serial [ms/step], parallel [ms/step], speedup, consistent";
 	{
-		for (auto it = m_bullets.begin(); it != m_bullets.end();)
-		{
-			if (not it->getPos().intersects(bounds))
-			{
-				m_bulletSet.erase(it->id());
-				it = m_bullets.erase(it);
-			}
-			else
-			{
-				++it;
-			}
-		}
+		constexpr int32 StepCount = 2000;
+		const StepBenchmarkResult result = RunStepBenchmark(StepCount, workerPool);
+
+		Console << U"{}, {}, {}, {:.3f}, {:.3f}, {:.2f}, {}"_fmt((workerPool.threadCount() + 1), StepCount, result.bulletCount,
+			result.serialMillisec, result.parallelMillisec, (result.serialMillisec / result.parallelMillisec), result.consistent);
 	}
 
-	/// @brief 指定したタイムスタンプ未満の弾を削除する
-	/// @param t タイムスタンプ
-	void removeOutDatad(TimestampSec t)
+	Console << U"restore steps, state [bytes], bullets, consistent";
 	{
-		for (auto it = m_bullets.begin(); it != m_bullets.end();)
-		{
-			if (m_bulletSet[it->id()] < t)
-			{
-				m_bulletSet.erase(it->id());
-				it = m_bullets.erase(it);
-			}
-			else
-			{
-				++it;
-			}
-		}
+		constexpr int32 StepCount = 1000;
+		const RestoreCheckResult result = RunRestoreCheck(StepCount);
+
+		Console << U"{}, {}, {}, {}"_fmt(StepCount, result.stateSize, result.bulletCount, result.consistent);
 	}
+}
 
-	/// @brief すべての弾を描画する
-	void draw() const
-	{
-		for (const auto& bullet : m_bullets)
-		{
-			const Vec2 pos = bullet.getPos();
+// 敵ユニットの波と自動の射撃で負荷を上げながら処理ごとの時間を計測し、CSV と JSON に保存して、波ごとに最も重い処理をコンソールに出力する関数
+void RunStress()
+{
+	WorkerPool workerPool{ (Max(Threading::GetConcurrency(), size_t{ 1 }) - 1) };
 
-			Circle{ pos, 5 }.draw();
+	const StressReport report = RunStressTest(StressTestConfig{}, &workerPool);
 
-			if (5.0 <= bullet.shape(0).getDensity())
-			{
-				Circle{ pos, 8 }.drawFrame(1);
-			}
-		}
-	}
+	SaveStressSummaryCSV(report, U"stress_summary.csv");
+	SaveStressHistogramCSV(report, U"stress_histogram.csv");
+	SaveStressReportJSON(report, U"stress_report.json");
+
+	Console << U"wave, enemies, bullets, light bullets, step p99 [us], slowest stage, slowest stage p99 [us]";
 
-	/// @brief 指定した P2Body が弾であるかを返す。
-	/// @param id P2BodyID
-	/// @return 指定した P2Body が弾である場合 true, それ以外の倍は false
-	bool isBullet(P2BodyID id) const
+	for (const auto& wave : report.waves)
 	{
-		return m_bulletSet.contains(id);
+		// 最後の要素は 1 ステップ全体
+		const auto& step = wave.stages.back();
+		const auto slowest = std::max_element(wave.stages.begin(), (wave.stages.end() - 1),
+			[](const StressStageStats& a, const StressStageStats& b) { return (a.p99Microsec < b.p99Microsec); });
+
+		Console << U"{}, {}, {:.0f}, {:.0f}, {:.1f}, {}, {:.1f}"_fmt(wave.wave, wave.enemyCount, wave.averageBulletCount, wave.averageLightBulletCount,
+			step.p99Microsec, slowest->name, slowest->p99Microsec);
 	}
 
-	/// @brief 状態を Print する
-	void showStats() const
+	// 1 ステップの処理が、ステップの時間に収まらなくなった最初の波
+	for (const auto& wave : report.waves)
 	{
-		assert(m_bullets.size() == m_bulletSet.size());
-		Print << U"active bullets: {}"_fmt(m_bullets.size());
+		if ((Simulation::StepSec * 1e6) < wave.stages.back().p99Microsec)
+		{
+			Console << U"step p99 exceeds {:.0f} us at wave {}"_fmt((Simulation::StepSec * 1e6), wave.wave);
+			break;
+		}
 	}
+}
 
-private:
+void Main()
+{
+# if defined(TOPDOWNSHOOTER_BENCHMARK)
 
-	// 空気抵抗の強さ
-	static constexpr double AirResistance = 0.002;
+	RunBenchmarks();
 
-	// アクティブな弾
-	Array<P2Body> m_bullets;
+# elif defined(TOPDOWNSHOOTER_STRESS)
 
-	// アクティブな弾の P2BodyID 一覧
-	HashTable<P2BodyID, TimestampSec> m_bulletSet;
-};
+	RunStress();
 
-P2Body AddWall(P2World& world, const RectF& rect)
-{
-	return world.createRect(P2Static, rect.center(), rect.size, {}, WallFilter);
-}
+# else
 
-void Main()
-{
 	// ウィンドウを 1280x720 にリサイズする
 	Window::Resize(1280, 720);
 
 	FontAsset::Register(U"BoldFont", FontMethod::MSDF, 32, Typeface::Bold);
 	const Font& boldFont = FontAsset(U"BoldFont");
 
-	// この範囲外に飛んだ弾は削除される
-	const RectF GameBounds{ -400, -250, 800, 500 };
+	// 通信の遅延とゆらぎの設定（秒）
+	constexpr std::array<std::pair<double, double>, 4> Latencies = { { { 0.0, 0.0 }, { 0.05, 0.01 }, { 0.1, 0.02 }, { 0.2, 0.04 } } };
+	size_t latencyIndex = 1;
+
+	// 2 人のプレイヤーのセッションを、遅延のある通信路でつなぐ
+	LoopbackChannel network{ LoopbackConfig{ .latencySec = Latencies[latencyIndex].first, .jitterSec = Latencies[latencyIndex].second } };
 
-	// 壁
-	const Rect Wall1Rect{ -300, -210, 600, 20 };
-	const Rect Wall2Rect{ -300, 190, 600, 20 };
-	const Circle FriendCircle{ -300, -100, 40 };
+	// 自分のセッション
+	RollbackSession session{ 0, network.endpoint(0) };
 
-	// 2D 物理演算のシミュレーションステップ（秒）
-	constexpr double StepSec = (1.0 / 200.0);
+	// 通信相手のセッション（同じプログラムの中で、自動で操作する）
+	RollbackSession remoteSession{ 1, network.endpoint(1) };
+
+	// 1 ステップの処理を並列に実行するワーカースレッド（呼び出し元のスレッドも処理に加わる）
+	WorkerPool workerPool{ (Max(Threading::GetConcurrency(), size_t{ 1 }) - 1) };
+	bool parallelStep = true;
+	session.setWorkerPool(&workerPool);
+	remoteSession.setWorkerPool(&workerPool);
 
 	// 2D 物理演算のシミュレーション蓄積時間（秒）
 	double accumulatorSec = 0.0;
 
-	// 2D 物理演算のワールド
-	P2World world{ 0.0 }; // 重力設定 0
-
-	// 壁
-	const P2Body wall1Body = AddWall(world, Wall1Rect);
-	const P2Body wall2Body = AddWall(world, Wall2Rect);
+	// 2D カメラ。初期中心座標: (0, 0), 拡大倍率: 1.0, 手動操作なし
+	Camera2D camera{ Vec2{ 0, 0 }, 1.0, CameraControl::None_ };
 
-	// 味方ユニット
-	P2Body friendBody = world.createCircle(P2Static, FriendCircle.center, FriendCircle.r, {}, FriendUnitFilter);
+	Circle player{ Simulation::PlayerPositions[0], 10 };
 
-	// 敵ユニット
-	HashTable<P2BodyID, Enemy> enemies;
-	{
-		{
-			Enemy e{ world.createCircle(P2Kinematic, Vec2{ 200, 100 }, Enemy::Radius, {}, EnemyUnitFilter), 3000, 3000, false };
-			enemies.emplace(e.body.id(), e);
-		}
+	// 軽量な弾を発射するか
+	bool lightBulletMode = false;
 
-		{
-			Enemy e{ world.createCircle(P2Kinematic, Vec2{ 300, 100 }, Enemy::Radius, {}, EnemyUnitFilter), 3000, 3000, true };
-			enemies.emplace(e.body.id(), e);
-		}
-	}
+	// 初速の速い弾を発射するか
+	bool fastBullet = false;
 
-	// 2D カメラ。初期中心座標: (0, 0), 拡大倍率: 1.0, 手動操作なし
-	Camera2D camera{ Vec2{ 0, 0 }, 1.0, CameraControl::None_ };
+	// まだステップに渡していない弾の発射（ステップが進まなかったフレームの入力は、次のステップに持ち越す）
+	ShotType pendingShot = ShotType::None;
 
-	Circle player{ 0, 0, 10 };
+	// 衝突エフェクト
+	RingEffectPool ringEffects{ 256 };
 
-	BulletList bulletList;
+	// 直近のフレームの状態更新でのメモリ確保の回数
+	uint64 updateAllocations = 0;
 
-	// ゲーム時刻
-	TimestampSec gameClock = 0.0;
-
-	Effect effect;
+	// 状態更新でのメモリ確保の回数の、計測中の 1 秒間での最大値と、直前の 1 秒間での最大値
+	uint64 maxUpdateAllocations = 0;
+	uint64 maxUpdateAllocationsLastSecond = 0;
+	Stopwatch allocationStopwatch{ StartImmediately::Yes };
 
 	while (System::Update())
 	{
@@ -298,100 +367,77 @@ void Main()
 		//
 		////////////////////////////////
 
+		const uint64 allocationsBeforeUpdate = AllocationCounter::Get();
+
 		// 自分の向き (rad)
 		const double angle = (Cursor::PosF() - Scene::CenterF()).getAngle();
 
+		// キーを押すと弾の種類を切り替える
+		if (KeyL.down())
+		{
+			lightBulletMode = (not lightBulletMode);
+		}
+
+		// キーを押すと弾の初速を切り替える
+		if (KeyH.down())
+		{
+			fastBullet = (not fastBullet);
+		}
+
 		// キーを押すと弾を発射する
 		if (KeyW.down() || KeyS.down())
 		{
-			const double speed = 500.0;
-			const Vec2 velocity = Circular{ speed, angle }; // 初速
-			const double density = (KeyW.down() ? 1.0 : 5.0); // 弾の密度（威力に影響）
-			bulletList.fire(world, player.center, velocity, density, gameClock);
+			pendingShot = (KeyW.down() ? ShotType::Light : ShotType::Heavy);
 		}
 
-		// 現在のフレームでの弾に関する衝突イベント
-		Array<CollisionEvent> bulletCollisionEvents;
+		// キーを押すと通信の遅延を切り替える
+		if (KeyN.down())
+		{
+			latencyIndex = ((latencyIndex + 1) % Latencies.size());
+			network.setLatency(Latencies[latencyIndex].first, Latencies[latencyIndex].second);
+		}
 
-		for (accumulatorSec += Scene::DeltaTime(); (StepSec <= accumulatorSec); accumulatorSec -= StepSec)
+		// キーを押すと 1 ステップの処理を並列に実行するかを切り替える
+		if (KeyP.down())
 		{
-			gameClock += StepSec;
+			parallelStep = (not parallelStep);
+			session.setWorkerPool(parallelStep ? &workerPool : nullptr);
+			remoteSession.setWorkerPool(parallelStep ? &workerPool : nullptr);
+		}
+
+		network.update(Scene::DeltaTime());
 
-			// すべての弾に空気抵抗相当の力を与える
-			bulletList.applyAirResistance(StepSec);
+		for (accumulatorSec += Scene::DeltaTime(); (Simulation::StepSec <= accumulatorSec); accumulatorSec -= Simulation::StepSec)
+		{
+			// 通信相手を進める（自分の操作を待っている場合は進まず、次のステップで改めて試す）
+			static_cast<void>(remoteSession.advance(MakeAutoInput(remoteSession.simulation().stepCount(), remoteSession.localPlayer())));
 
-			// enemy2 を移動させる
-			for (auto&& [id, enemy] : enemies)
+			// 通信相手の操作を待っている間は時間を進めない
+			if (not session.advance(PlayerInput{ .angle = angle, .shot = pendingShot, .lightBulletMode = lightBulletMode, .fastBullet = fastBullet }))
 			{
-				if (enemy.move)
-				{
-					enemy.body.setPos(enemy.body.getPos().x, Math::Sin(gameClock * 45_deg) * 100);
-				}
+				accumulatorSec = 0.0;
+				break;
 			}
 
-			// 2D 物理演算のワールドを更新する
-			world.update(StepSec);
+			pendingShot = ShotType::None;
 
-			// 接触イベントを取得する
-			for (auto&& [pair, collision] : world.getCollisions())
+			for (const auto& event : session.simulation().events())
 			{
-				// 弾が関わらない接触はスキップする
-				if ((not bulletList.isBullet(pair.a))
-					&& (not bulletList.isBullet(pair.b)))
-				{
-					continue;
-				}
-
-				for (const auto& c : collision)
-				{
-					// 接触イベントを構築する
-					const CollisionEvent ce
-					{
-						.a = pair.a,
-						.b = pair.b,
-						.pos = c.point,
-						.normalImpulse = c.normalImpulse,
-						.tangentImpulse = Abs(c.tangentImpulse),
-						.timestamp = gameClock
-					};
-
-					// 接触イベント配列に追加する
-					bulletCollisionEvents << ce;
-
-					effect.add<RingEffect>(ce.pos, ce.normalImpulse);
-				}
-
-				// 接触した弾を削除する
-				bulletList.remove(pair.a);
-				bulletList.remove(pair.b);
+				ringEffects.add(event.pos, event.normalImpulse);
 			}
 		}
 
-		// 画面外に出た弾を削除する
-		bulletList.removeOutOfBounds(GameBounds);
-
-		// 発射から 5 秒以上経過した弾を削除する
-		bulletList.removeOutDatad(gameClock - 5.0);
+		// 状態更新でのメモリ確保の回数を記録する
+		updateAllocations = (AllocationCounter::Get() - allocationsBeforeUpdate);
+		maxUpdateAllocations = Max(maxUpdateAllocations, updateAllocations);
 
-		// 敵ユニットに弾によるダメージを与える
-		for (const auto& bulletCollisionEvent : bulletCollisionEvents)
+		if (1.0 <= allocationStopwatch.sF())
 		{
-			if (auto it = enemies.find(bulletCollisionEvent.a);
-				it != enemies.end())
-			{
-				it->second.damage(bulletCollisionEvent.normalImpulse);
-			}
-
-			if (auto it = enemies.find(bulletCollisionEvent.b);
-					it != enemies.end())
-			{
-				it->second.damage(bulletCollisionEvent.normalImpulse);
-			}
+			maxUpdateAllocationsLastSecond = maxUpdateAllocations;
+			maxUpdateAllocations = 0;
+			allocationStopwatch.restart();
 		}
 
-		// HP が 0 以下の敵ユニットを削除する
-		EraseNodes_if(enemies, [](const auto& e) { return (e.second.hp <= 0); });
-
 		////////////////////////////////
 		//
 		//	描画
@@ -401,27 +447,59 @@ void Main()
 		ClearPrint();
 		Print << U"[W] 軽い弾を発射";
 		Print << U"[S] 重い弾を発射";
-		Print << U"gameClock: {:.2f}"_fmt(gameClock);
-		bulletList.showStats();
+		Print << U"[L] 弾の種類を切り替え（現在: {}）"_fmt(lightBulletMode ? U"軽量な弾" : U"P2Body の弾");
+		Print << U"[H] 弾の初速を切り替え（現在: {:.0f}）"_fmt(fastBullet ? Simulation::FastBulletSpeed : Simulation::BulletSpeed);
+		Print << U"[N] 通信の遅延を切り替え（現在: {:.0f} ms ± {:.0f} ms）"_fmt((network.config().latencySec * 1000), (network.config().jitterSec * 1000));
+		Print << U"[P] 1 ステップの処理の並列化を切り替え（現在: {} スレッド）"_fmt(parallelStep ? (workerPool.threadCount() + 1) : 1);
+		session.simulation().showStats();
+		Print << U"ring effects: {}"_fmt(ringEffects.size());
+		Print << U"snapshot: {} bytes (delta), {} bytes (history)"_fmt(session.history().latestByteSize(), session.history().byteSize());
+		{
+			const RollbackStats& stats = session.stats();
+			Print << U"step: {} (confirmed: {})"_fmt(session.simulation().stepCount(), session.confirmedStep());
+			Print << U"rollbacks: {}, resimulated steps: {} (max {}), {:.3f} ms per resimulated step, stalls: {}"_fmt(
+				stats.rollbackCount, stats.resimulatedSteps, stats.maxResimulatedSteps, stats.millisecPerResimulatedStep(), stats.stallCount);
+
+			// 通信相手と状態がずれていないか
+			if (session.isHalted())
+			{
+				Print << U"halted: failed to restore a state";
+			}
+
+			if (const auto desyncStep = session.desyncStep())
+			{
+				Print << U"desync detected at step {} ({} of {} checked states differ, {} resyncs)"_fmt(*desyncStep, stats.desyncCount, stats.checkedStateCount, stats.resyncCount);
+			}
+			else
+			{
+				Print << U"states in sync ({} checked)"_fmt(stats.checkedStateCount);
+			}
+		}
+
+		// 他のスレッドでの確保も数えるので目安
+		if constexpr (AllocationCounter::Enabled)
+		{
+			Print << U"allocations in update (all threads): {} (max in last second: {})"_fmt(updateAllocations, maxUpdateAllocationsLastSecond);
+		}
+		else
+		{
+			Print << U"allocations in update: not counted (build with TOPDOWNSHOOTER_COUNT_ALLOCATIONS)";
+		}
 
 		{
 			// 2D カメラから Transformer2D を作成する
 			const auto tr = camera.createTransformer();
 
-			GameBounds.draw(ColorF{ 0.3 });
-			Wall1Rect.draw();
-			Wall2Rect.draw();
-			bulletList.draw();
+			session.simulation().draw(boldFont);
 			player.draw(Palette::Yellow);
 			Line{ player.center, Arg::angle = angle, 40.0 }.drawArrow(2, SizeF{ 10, 10 }, Palette::Yellow);
-			friendBody.draw(Palette::Yellow);
 
-			for (auto&& [id, enemy] : enemies)
-			{
-				enemy.draw(boldFont);
-			}
+			// 通信相手の向き（まだ届いていなければ予測）
+			Line{ Simulation::PlayerPositions[1], Arg::angle = session.latestInput(1).angle, 80.0 }.drawArrow(2, SizeF{ 10, 10 }, Palette::Yellow);
 
-			effect.update();
+			ringEffects.update(boldFont);
 		}
 	}
+
+# endif
 }
@@ -0,0 +1,696 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Simulation.hpp"
+# include "Snapshot.hpp"
+
+/// @brief 通信で送る、1 ステップ分のプレイヤーの操作
+struct InputMessage
+{
+	/// @brief 操作を使うステップ（このステップの状態から 1 ステップ進めるときに使う）
+	uint64 step = 0;
+
+	/// @brief プレイヤーの番号
+	uint8 player = 0;
+
+	/// @brief 操作
+	PlayerInput input;
+
+	/// @brief 送り手で、すべてのプレイヤーの操作が確定している最後のステップ数（checksum の状態のステップ数）
+	uint64 checksumStep = 0;
+
+	/// @brief 送り手での、checksumStep の状態のチェックサム (StateChecksum())
+	uint64 checksum = 0;
+
+	/// @brief 送り手が最後に状態を読み込み直したステップ数（読み込み直していなければ 0）
+	uint64 resyncStep = 0;
+
+	/// @brief 状態のずれを直すために送る、checksumStep の状態（ふつうは空）
+	Array<uint8> state;
+};
+
+/// @brief ロールバックのセッションが、ほかのプレイヤーと操作を送受信する通信路のインタフェース
+/// @remark メッセージは遅れたり、送った順番と入れ替わったりして届いてもかまいませんが、失われてはいけません。
+class IInputTransport
+{
+public:
+
+	virtual ~IInputTransport() = default;
+
+	/// @brief ほかのプレイヤーにメッセージを送ります。
+	/// @param message メッセージ
+	virtual void send(const InputMessage& message) = 0;
+
+	/// @brief 届いたメッセージを 1 つ取り出します。
+	/// @param message 取り出したメッセージの書き込み先
+	/// @return 取り出した場合 true, 届いたメッセージが無い場合は false
+	[[nodiscard]]
+	virtual bool receive(InputMessage& message) = 0;
+};
+
+/// @brief 同じプログラムの中の 2 つのセッションをつなぐ通信路の設定
+struct LoopbackConfig
+{
+	/// @brief 遅延（秒）
+	double latencySec = 0.05;
+
+	/// @brief 遅延のゆらぎの最大値（秒）。メッセージごとに 0 からこの値までの一様乱数を遅延に加える
+	double jitterSec = 0.01;
+
+	/// @brief ゆらぎの乱数のシード
+	uint64 seed = 0;
+};
+
+/// @brief 同じプログラムの中の 2 つのセッションを、人為的な遅延とそのゆらぎを加えてつなぐ通信路
+/// @remark 時刻は update() で進めた分だけ進むので、実時間でも、シミュレーションのステップ単位でも使えます。
+/// ゆらぎにより、メッセージは送った順番と入れ替わって届くことがあります。
+class LoopbackChannel
+{
+public:
+
+	/// @brief 通信路を作成します。
+	/// @param config 設定
+	explicit LoopbackChannel(const LoopbackConfig& config)
+		: m_config{ config }
+		, m_rng{ config.seed }
+		, m_endpoints{ { Endpoint{ *this, 0 }, Endpoint{ *this, 1 } } } {}
+
+	LoopbackChannel(const LoopbackChannel&) = delete;
+
+	LoopbackChannel& operator =(const LoopbackChannel&) = delete;
+
+	/// @brief 通信路の時刻を進めます。
+	/// @param deltaSec 進める時間（秒）
+	void update(double deltaSec)
+	{
+		m_timeSec += deltaSec;
+	}
+
+	/// @brief 遅延とゆらぎを変更します。すでに送ったメッセージが届く時刻は変わりません。
+	/// @param latencySec 遅延（秒）
+	/// @param jitterSec 遅延のゆらぎの最大値（秒）
+	void setLatency(double latencySec, double jitterSec)
+	{
+		m_config.latencySec = latencySec;
+		m_config.jitterSec = jitterSec;
+	}
+
+	/// @brief 設定を返します。
+	[[nodiscard]]
+	const LoopbackConfig& config() const noexcept
+	{
+		return m_config;
+	}
+
+	/// @brief 通信路の一方の端を返します。
+	/// @param side 0 または 1. 一方の端で送ったメッセージは、もう一方の端で受け取れる
+	[[nodiscard]]
+	IInputTransport& endpoint(size_t side)
+	{
+		return m_endpoints[side];
+	}
+
+	/// @brief まだ届いていないメッセージの数を返します。
+	[[nodiscard]]
+	size_t inFlightCount() const noexcept
+	{
+		return (m_packets[0].size() + m_packets[1].size());
+	}
+
+private:
+
+	class Endpoint : public IInputTransport
+	{
+	public:
+
+		Endpoint(LoopbackChannel& channel, size_t side)
+			: m_channel{ &channel }
+			, m_side{ side } {}
+
+		void send(const InputMessage& message) override
+		{
+			m_channel->post((1 - m_side), message);
+		}
+
+		[[nodiscard]]
+		bool receive(InputMessage& message) override
+		{
+			return m_channel->take(m_side, message);
+		}
+
+	private:
+
+		LoopbackChannel* m_channel;
+
+		size_t m_side;
+	};
+
+	struct Packet
+	{
+		// 届く時刻（秒）
+		double arrivalSec;
+
+		InputMessage message;
+	};
+
+	LoopbackConfig m_config;
+
+	DefaultRNG m_rng;
+
+	double m_timeSec = 0.0;
+
+	// 端ごとの、まだ受け取られていないメッセージ
+	std::array<Array<Packet>, 2> m_packets;
+
+	std::array<Endpoint, 2> m_endpoints;
+
+	void post(size_t side, const InputMessage& message)
+	{
+		const double jitterSec = ((0.0 < m_config.jitterSec) ? Random(0.0, m_config.jitterSec, m_rng) : 0.0);
+		m_packets[side] << Packet{ (m_timeSec + m_config.latencySec + jitterSec), message };
+	}
+
+	bool take(size_t side, InputMessage& message)
+	{
+		Array<Packet>& packets = m_packets[side];
+
+		// 届いたメッセージのうち、最も早く届いたものを取り出す
+		size_t index = packets.size();
+
+		for (size_t i = 0; i < packets.size(); ++i)
+		{
+			if ((packets[i].arrivalSec <= m_timeSec)
+				&& ((index == packets.size()) || (packets[i].arrivalSec < packets[index].arrivalSec)))
+			{
+				index = i;
+			}
+		}
+
+		if (index == packets.size())
+		{
+			return false;
+		}
+
+		message = packets[index].message;
+		packets[index] = packets.back();
+		packets.pop_back();
+		return true;
+	}
+};
+
+/// @brief ロールバックによる再シミュレーションの統計
+struct RollbackStats
+{
+	/// @brief ロールバックした回数
+	uint64 rollbackCount = 0;
+
+	/// @brief ロールバックで再シミュレーションしたステップの合計
+	uint64 resimulatedSteps = 0;
+
+	/// @brief 1 回のロールバックで再シミュレーションしたステップの最大値
+	uint64 maxResimulatedSteps = 0;
+
+	/// @brief ロールバックにかかった時間の合計（ミリ秒）。状態の復元と、再シミュレーションした各ステップの状態の保存を含む
+	double resimulationMillisec = 0.0;
+
+	/// @brief ほかのプレイヤーの操作を待つためにステップを進めなかった回数
+	uint64 stallCount = 0;
+
+	/// @brief 通信相手と状態のチェックサムを比べたステップの数
+	uint64 checkedStateCount = 0;
+
+	/// @brief 通信相手と状態のチェックサムが一致しなかったステップの数
+	uint64 desyncCount = 0;
+
+	/// @brief 状態のずれを直すために、確定したステップの状態を読み込み直した回数
+	uint64 resyncCount = 0;
+
+	/// @brief 状態を復元できなかったために、セッションを止めた回数
+	uint64 haltCount = 0;
+
+	/// @brief 再シミュレーションした 1 ステップあたりの時間（ミリ秒）を返します。
+	[[nodiscard]]
+	double millisecPerResimulatedStep() const noexcept
+	{
+		return ((resimulatedSteps == 0) ? 0.0 : (resimulationMillisec / resimulatedSteps));
+	}
+};
+
+/// @brief ロールバック方式で、ほかのプレイヤーとシミュレーションを同期するセッション
+/// @remark 自分の操作はすぐにシミュレーションに使い、まだ届いていないほかのプレイヤーの操作は、直前のステップの操作（弾は撃たない）と同じだと予測して先に進めます。
+/// 届いた操作が予測と違っていた場合は、そのステップの状態を履歴から復元し、現在のステップまでを正しい操作で再シミュレーションします。
+/// ほかのプレイヤーの操作が MaxPredictionSteps ステップ以上届かない場合は、届くまでステップを進めません。
+/// @remark 状態を一度も復元していないシミュレーションと、復元したシミュレーションでは、物理演算エンジン内部の状態が違うので、ロールバックしたセッションと、しなかったセッションの状態がずれる可能性があります。
+/// これを検出するために、すべての操作が確定したステップの状態のチェックサムを操作と一緒に送り、受け取ったチェックサムを自分の同じステップの状態と比べます。
+/// 一致しなかった場合は、プレイヤー ResyncPlayer のセッションが、そのとき確定している最後のステップの状態を次の操作と一緒に送り、
+/// 両方のセッションがその状態を Simulation::load() で読み込んで、現在のステップまで再シミュレーションします。
+/// load() は物理演算ワールドを作り直すので、同じ状態を読み込んだ 2 つのセッションは、その後も同じ操作からビット単位で同じ状態になります。
+/// 直している間に届いた、読み込み直す前の状態のチェックサムは、ずれとして数えますが、もう一度直すことはしません。
+/// @remark 履歴から状態を復元できなかった場合は、セッションを止めて (isHalted())、ステップを進めません。ほかのセッションから状態が届いて読み込み直すと、再び進めます。
+class RollbackSession
+{
+public:
+
+	/// @brief 予測で先に進めるステップ数の上限
+	static constexpr uint64 MaxPredictionSteps = 60;
+
+	/// @brief 状態がずれたときに、自分の状態を送るプレイヤーの番号
+	static constexpr size_t ResyncPlayer = 0;
+
+	/// @brief セッションを作成します。
+	/// @param localPlayer このセッションで操作するプレイヤーの番号
+	/// @param transport ほかのプレイヤーとの通信路（セッションより長く存在する必要があります）
+	RollbackSession(size_t localPlayer, IInputTransport& transport)
+		: m_localPlayer{ localPlayer }
+		, m_transport{ &transport }
+		, m_history{ (MaxPredictionSteps + SnapshotHistory::KeyframeInterval + 2) }
+	{
+		for (auto& inputs : m_inputs)
+		{
+			inputs.resize(InputBufferSize);
+		}
+
+		m_simulation.save(m_state);
+		m_history.push(m_simulation.stepCount(), m_state);
+		m_checksums.resize(InputBufferSize);
+		m_checksums[0] = StateChecksumEntry{ 0, StateChecksum(m_state) };
+	}
+
+	/// @brief シミュレーションの 1 ステップの処理を並列に実行するワーカースレッドを設定します。
+	/// @param pool ワーカースレッド。nullptr の場合は、すべて呼び出し元のスレッドで実行します
+	void setWorkerPool(WorkerPool* pool) noexcept
+	{
+		m_simulation.setWorkerPool(pool);
+	}
+
+	/// @brief 届いた操作を反映してから、自分の操作でシミュレーションを 1 ステップ進めます。
+	/// @param localInput このステップの自分の操作
+	/// @return ステップを進めた場合 true, ほかのプレイヤーの操作を待つためか、セッションを止めているために進めなかった場合は false（自分の操作は送られないので、次の呼び出しで渡し直します）
+	[[nodiscard]]
+	bool advance(const PlayerInput& localInput)
+	{
+		poll();
+
+		if (m_halted)
+		{
+			++m_stats.stallCount;
+			return false;
+		}
+
+		const uint64 step = m_simulation.stepCount();
+
+		for (size_t player = 0; player < Simulation::PlayerCount; ++player)
+		{
+			if ((m_confirmedSteps[player] + MaxPredictionSteps) <= step)
+			{
+				++m_stats.stallCount;
+				return false;
+			}
+		}
+
+		// 操作と一緒に、すべての操作が確定している最後のステップの状態のチェックサムを送る（そのステップの状態はもう変わらない）
+		const uint64 checksumStep = confirmedStep();
+
+		InputMessage message{ step, static_cast<uint8>(m_localPlayer), localInput, checksumStep, m_checksums[checksumStep % InputBufferSize].checksum };
+
+		// 状態がずれていれば、その状態も送り、自分も読み込み直す
+		if (m_resyncRequested)
+		{
+			if (m_history.restore(checksumStep, message.state)
+				&& resync(checksumStep, message.state))
+			{
+				m_resyncRequested = false;
+			}
+			else
+			{
+				message.state.clear();
+			}
+
+			if (m_halted)
+			{
+				++m_stats.stallCount;
+				return false;
+			}
+		}
+
+		message.resyncStep = m_resyncStep;
+
+		m_inputs[m_localPlayer][step % InputBufferSize] = InputEntry{ step, localInput, true };
+		m_confirmedSteps[m_localPlayer] = (step + 1);
+		m_transport->send(message);
+
+		simulateStep(step);
+
+		return true;
+	}
+
+	/// @brief 届いた操作を受け取り、予測が外れていればロールバックします。
+	void poll()
+	{
+		InputMessage message;
+
+		while (m_transport->receive(message))
+		{
+			const size_t player = message.player;
+
+			if ((Simulation::PlayerCount <= player)
+				|| (player == m_localPlayer))
+			{
+				continue;
+			}
+
+			m_remoteChecksums << RemoteChecksumEntry{ message.checksumStep, message.checksum, message.resyncStep };
+
+			// 新しい状態が届いたら、確定したものとして読み込み直す
+			if ((not message.state.isEmpty()) && (m_resyncStep < message.checksumStep))
+			{
+				m_pendingStep = message.checksumStep;
+				m_pendingState = message.state;
+			}
+
+			if ((message.step < m_confirmedSteps[player])
+				|| ((m_confirmedSteps[player] + InputBufferSize) <= message.step))
+			{
+				continue;
+			}
+
+			InputEntry& entry = m_inputs[player][message.step % InputBufferSize];
+
+			if ((entry.step == message.step) && entry.confirmed)
+			{
+				continue;
+			}
+
+			// すでに予測で進めたステップの操作が予測と違っていたら、そのステップからやり直す
+			if ((message.step < m_simulation.stepCount())
+				&& ((entry.step != message.step) || (entry.input != message.input)))
+			{
+				m_rollbackStep = Min(m_rollbackStep, message.step);
+			}
+
+			entry = InputEntry{ message.step, message.input, true };
+
+			updateConfirmedStep(player);
+		}
+
+		if (m_pendingStep)
+		{
+			if (resync(*m_pendingStep, m_pendingState))
+			{
+				// 読み込み直した状態より前のステップの操作は、もう使わない
+				for (size_t player = 0; player < Simulation::PlayerCount; ++player)
+				{
+					m_confirmedSteps[player] = Max(m_confirmedSteps[player], *m_pendingStep);
+					updateConfirmedStep(player);
+				}
+
+				m_rollbackStep = Largest<uint64>;
+			}
+
+			m_pendingStep.reset();
+		}
+
+		if ((m_rollbackStep != Largest<uint64>) && (not m_halted))
+		{
+			if (not rollback())
+			{
+				++m_stats.haltCount;
+				m_halted = true;
+			}
+		}
+
+		checkRemoteChecksums();
+	}
+
+	/// @brief シミュレーションを返します。
+	[[nodiscard]]
+	const Simulation& simulation() const noexcept
+	{
+		return m_simulation;
+	}
+
+	/// @brief このセッションで操作するプレイヤーの番号を返します。
+	[[nodiscard]]
+	size_t localPlayer() const noexcept
+	{
+		return m_localPlayer;
+	}
+
+	/// @brief すべてのプレイヤーの操作が確定しているステップ数を返します。これより前のステップの状態は、今後ロールバックで変わることはありません。
+	[[nodiscard]]
+	uint64 confirmedStep() const noexcept
+	{
+		return *std::min_element(m_confirmedSteps.begin(), m_confirmedSteps.end());
+	}
+
+	/// @brief 直前のステップで使った、指定したプレイヤーの操作（予測を含む）を返します。
+	/// @param player プレイヤーの番号
+	[[nodiscard]]
+	const PlayerInput& latestInput(size_t player) const noexcept
+	{
+		return m_stepInputs[player];
+	}
+
+	/// @brief 通信相手と状態のチェックサムが最初に一致しなかったステップ数を返します。
+	/// @return 一致しなかったステップ数。すべて一致している場合は none
+	[[nodiscard]]
+	Optional<uint64> desyncStep() const noexcept
+	{
+		return m_desyncStep;
+	}
+
+	/// @brief 状態を復元できなかったために、セッションを止めているかを返します。
+	[[nodiscard]]
+	bool isHalted() const noexcept
+	{
+		return m_halted;
+	}
+
+	/// @brief ロールバックの統計を返します。
+	[[nodiscard]]
+	const RollbackStats& stats() const noexcept
+	{
+		return m_stats;
+	}
+
+	/// @brief 状態の履歴を返します。
+	[[nodiscard]]
+	const SnapshotHistory& history() const noexcept
+	{
+		return m_history;
+	}
+
+private:
+
+	// 操作を記録しておくステップ数（自分より先に進んでいるプレイヤーの操作も入るように、予測の上限より十分大きくする）
+	static constexpr uint64 InputBufferSize = (MaxPredictionSteps * 4);
+
+	struct InputEntry
+	{
+		uint64 step = Largest<uint64>;
+
+		PlayerInput input;
+
+		// 届いた操作であれば true, 予測した操作であれば false
+		bool confirmed = false;
+	};
+
+	struct StateChecksumEntry
+	{
+		uint64 step = Largest<uint64>;
+
+		uint64 checksum = 0;
+	};
+
+	struct RemoteChecksumEntry
+	{
+		uint64 step = Largest<uint64>;
+
+		uint64 checksum = 0;
+
+		// 送り手が最後に状態を読み込み直したステップ数
+		uint64 resyncStep = 0;
+	};
+
+	size_t m_localPlayer;
+
+	IInputTransport* m_transport;
+
+	Simulation m_simulation;
+
+	// 各ステップの後の状態（ロールバックの起点）
+	SnapshotHistory m_history;
+
+	// 状態の書き込み先（使い回す）
+	Array<uint8> m_state;
+
+	// プレイヤーごとの、各ステップの操作（step % InputBufferSize の位置に入れる）
+	std::array<Array<InputEntry>, Simulation::PlayerCount> m_inputs;
+
+	// プレイヤーごとの、途切れずに操作が確定しているステップ数
+	std::array<uint64, Simulation::PlayerCount> m_confirmedSteps{};
+
+	// 予測が外れていた最初のステップ（無ければ Largest<uint64>）
+	uint64 m_rollbackStep = Largest<uint64>;
+
+	// 直前のステップで使った操作
+	Simulation::PlayerInputs m_stepInputs{};
+
+	RollbackStats m_stats;
+
+	// 各ステップの後の状態のチェックサム（step % InputBufferSize の位置に入れる）
+	Array<StateChecksumEntry> m_checksums;
+
+	// 受け取ったが、まだ自分の状態と比べていない、通信相手の状態のチェックサム
+	Array<RemoteChecksumEntry> m_remoteChecksums;
+
+	// 通信相手とチェックサムが最初に一致しなかったステップ数
+	Optional<uint64> m_desyncStep;
+
+	// 次の advance() で、自分の状態を送って読み込み直すか（プレイヤー ResyncPlayer のセッションだけが使う）
+	bool m_resyncRequested = false;
+
+	// 最後に状態を読み込み直したステップ数（読み込み直していなければ 0）
+	uint64 m_resyncStep = 0;
+
+	// 届いたが、まだ読み込み直していない状態と、そのステップ数
+	Optional<uint64> m_pendingStep;
+
+	Array<uint8> m_pendingState;
+
+	// 状態を復元できなかったために、セッションを止めているか
+	bool m_halted = false;
+
+	// 指定したプレイヤーの、途切れずに確定しているステップを進める
+	void updateConfirmedStep(size_t player)
+	{
+		for (uint64& confirmed = m_confirmedSteps[player];
+			(m_inputs[player][confirmed % InputBufferSize].step == confirmed) && m_inputs[player][confirmed % InputBufferSize].confirmed;
+			++confirmed) {}
+	}
+
+	// 指定したステップの操作を集め（まだ届いていない操作は予測し）、シミュレーションを 1 ステップ進めて状態を保存する
+	void simulateStep(uint64 step)
+	{
+		for (size_t player = 0; player < Simulation::PlayerCount; ++player)
+		{
+			InputEntry& entry = m_inputs[player][step % InputBufferSize];
+
+			if ((entry.step != step) || (not entry.confirmed))
+			{
+				// 直前のステップと同じ向きと弾の種類で、弾は撃たないと予測する
+				const InputEntry& previous = m_inputs[player][(step + InputBufferSize - 1) % InputBufferSize];
+				PlayerInput prediction = (((step != 0) && (previous.step == (step - 1))) ? previous.input : PlayerInput{});
+				prediction.shot = ShotType::None;
+
+				entry = InputEntry{ step, prediction, false };
+			}
+
+			m_stepInputs[player] = entry.input;
+		}
+
+		m_simulation.step(m_stepInputs);
+		m_simulation.save(m_state);
+		m_history.push(m_simulation.stepCount(), m_state);
+		m_checksums[m_simulation.stepCount() % InputBufferSize] = StateChecksumEntry{ m_simulation.stepCount(), StateChecksum(m_state) };
+	}
+
+	// 受け取ったチェックサムのうち、自分でもすべての操作が確定したステップのものを、自分の状態のチェックサムと比べる
+	void checkRemoteChecksums()
+	{
+		const uint64 confirmed = confirmedStep();
+
+		m_remoteChecksums.remove_if([&](const RemoteChecksumEntry& remote)
+			{
+				if (confirmed < remote.step)
+				{
+					return false;
+				}
+
+				const StateChecksumEntry& local = m_checksums[remote.step % InputBufferSize];
+
+				// 古すぎて自分のチェックサムが残っていないものは比べずに捨てる
+				if (local.step == remote.step)
+				{
+					++m_stats.checkedStateCount;
+
+					if (local.checksum != remote.checksum)
+					{
+						++m_stats.desyncCount;
+						m_desyncStep = Min(m_desyncStep.value_or(Largest<uint64>), remote.step);
+
+						// 直前に送った状態を、相手がまだ読み込んでいなかったときのずれであれば、もう一度は送らない
+						if ((m_localPlayer == ResyncPlayer) && (remote.resyncStep == m_resyncStep))
+						{
+							m_resyncRequested = true;
+						}
+					}
+				}
+
+				return true;
+			});
+	}
+
+	// 予測が外れていたステップの状態に戻し、現在のステップまで再シミュレーションする。状態を復元できなかった場合は false を返す
+	[[nodiscard]]
+	bool rollback()
+	{
+		const uint64 fromStep = m_rollbackStep;
+		const uint64 toStep = m_simulation.stepCount();
+		m_rollbackStep = Largest<uint64>;
+
+		const uint64 start = Time::GetNanosec();
+
+		if ((not m_history.restore(fromStep, m_state))
+			|| (not m_simulation.load(m_state)))
+		{
+			return false;
+		}
+
+		for (uint64 step = fromStep; step < toStep; ++step)
+		{
+			simulateStep(step);
+		}
+
+		++m_stats.rollbackCount;
+		m_stats.resimulatedSteps += (toStep - fromStep);
+		m_stats.maxResimulatedSteps = Max(m_stats.maxResimulatedSteps, (toStep - fromStep));
+		m_stats.resimulationMillisec += ((Time::GetNanosec() - start) / 1e6);
+
+		return true;
+	}
+
+	// すべての操作が確定したステップの状態を読み込み直し、現在のステップまで再シミュレーションする。読み込み直さなかった場合は false を返す
+	[[nodiscard]]
+	bool resync(uint64 fromStep, const Array<uint8>& state)
+	{
+		const uint64 toStep = m_simulation.stepCount();
+
+		// 現在より先のステップの状態や、自分の操作がもう残っていないステップの状態は使えない
+		if ((toStep < fromStep) || (InputBufferSize <= (toStep - fromStep)))
+		{
+			return false;
+		}
+
+		// 読み込めなかった場合、シミュレーションの状態は不定なので、セッションを止める
+		if ((not m_simulation.load(state)) || (m_simulation.stepCount() != fromStep))
+		{
+			++m_stats.haltCount;
+			m_halted = true;
+			return false;
+		}
+
+		m_history.push(fromStep, state);
+		m_checksums[fromStep % InputBufferSize] = StateChecksumEntry{ fromStep, StateChecksum(state) };
+
+		for (uint64 step = fromStep; step < toStep; ++step)
+		{
+			simulateStep(step);
+		}
+
+		m_resyncStep = fromStep;
+		m_halted = false;
+		++m_stats.resyncCount;
+
+		return true;
+	}
+};
@@ -0,0 +1,544 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Bullets.hpp"
+# include "Common.hpp"
+# include "Enemies.hpp"
+# include "LightBullets.hpp"
+# include "Snapshot.hpp"
+# include "TaskGraph.hpp"
+
+/// @brief 発射する弾
+enum class ShotType : uint8
+{
+	None,	// 発射しない
+	Light,	// 軽い弾
+	Heavy,	// 重い弾
+};
+
+/// @brief 1 ステップ分のプレイヤーの操作
+struct PlayerInput
+{
+	/// @brief 自分の向き (rad)
+	double angle = 0.0;
+
+	/// @brief 発射する弾
+	ShotType shot = ShotType::None;
+
+	/// @brief P2Body を使わない軽量な弾を発射するか
+	bool lightBulletMode = false;
+
+	/// @brief 初速の速い弾を発射するか
+	bool fastBullet = false;
+
+	[[nodiscard]]
+	bool operator ==(const PlayerInput&) const = default;
+};
+
+/// @brief 固定ステップで進めるゲームのシミュレーション（物理演算ワールド、弾、敵ユニット、ゲーム時刻）
+/// @remark プレイヤーは 2 人で、2 人目は味方ユニットの位置から弾を撃ちます。
+/// @remark 状態は、同じ状態から同じ操作の列を与えれば同じ結果になるように、ステップ単位でだけ変化します。
+/// save() で状態をバイト列に書き込み、load() で書き込んだ状態に戻します。
+/// load() は物理演算ワールドを作り直し、壁・味方ユニット・敵ユニット・弾の P2Body を決まった順に作って、位置・角度・速度・角速度などを保存したときの値にビット単位で戻します。
+/// 物理演算エンジン内部の接触のキャッシュや、ブロードフェーズの組の順番は、それまでの履歴によらず、作り直した直後の状態になります。
+/// そのため、同じ状態を load() してから同じ操作の列を与えれば、どのシミュレーションで何回 load() しても、結果はビット単位で同じになります（RunRestoreCheck() で確かめます）。
+/// 一度も load() していないシミュレーションとは、物理演算エンジン内部の状態が違うので、結果が一致するとは限りません。
+/// ロールバックでは、状態のチェックサムを通信相手と比べ、ずれた場合は、確定したステップの状態を受け取って load() し直します (RollbackSession)。
+/// 1 ステップの処理は、読み書きするデータから依存関係を決めたタスクグラフ (TaskGraph) で実行し、ワーカースレッドを設定すると、互いに依存しない処理を並列に実行します。
+/// 物理演算ワールドの更新は、ほかのどの処理とも同時には実行しません。並列に実行しても、結果は 1 つのスレッドで実行した場合とビット単位で同じになります。
+class Simulation
+{
+public:
+
+	/// @brief 1 ステップの時間（秒）
+	static constexpr double StepSec = (1.0 / 200.0);
+
+	/// @brief 弾が消えるまでの時間（秒）
+	static constexpr double BulletLifetimeSec = 5.0;
+
+	/// @brief この範囲外に飛んだ弾は削除される
+	static constexpr RectF GameBounds{ -400, -250, 800, 500 };
+
+	/// @brief 壁
+	static constexpr std::array<RectF, 2> WallRects = { RectF{ -300, -210, 600, 20 }, RectF{ -300, 190, 600, 20 } };
+
+	/// @brief 味方ユニット
+	static constexpr Circle FriendCircle{ -300, -100, 40 };
+
+	/// @brief プレイヤーの人数
+	static constexpr size_t PlayerCount = 2;
+
+	/// @brief 各プレイヤーの弾の発射位置
+	static constexpr std::array<Vec2, PlayerCount> PlayerPositions = { Vec2{ 0, 0 }, FriendCircle.center };
+
+	/// @brief 1 ステップ分の、すべてのプレイヤーの操作
+	using PlayerInputs = std::array<PlayerInput, PlayerCount>;
+
+	/// @brief 弾の初速
+	static constexpr double BulletSpeed = 500.0;
+
+	/// @brief 速い弾の初速（1 ステップで壁の厚さより長く動く）
+	static constexpr double FastBulletSpeed = 10000.0;
+
+	/// @brief 1 ステップでこの距離以上動いた P2Body の弾は、移動前の位置から現在の位置までの線分でも壁や敵ユニットとの衝突を調べる
+	static constexpr double SweepMinDistance = BulletRadius;
+
+	/// @brief ゲームの初期状態を作ります。
+	Simulation()
+		: m_world{ 0.0 } // 重力設定 0
+		, m_stepGraph{ MakeStepGraph() }
+	{
+		createStaticBodies();
+
+		// 敵ユニット
+		addEnemy(Vec2{ 200, 100 }, 3000, false);
+		addEnemy(Vec2{ 300, 100 }, 3000, true);
+
+		// 弾の P2Body を作っておく
+		m_bullets.reserve(m_world, 1024);
+
+		m_lightBullets = LightBulletList{ GetBulletMassPerDensity(m_world) };
+		m_events.reserve(1024);
+		m_lightEvents.reserve(1024);
+	}
+
+	/// @brief 1 ステップの処理を並列に実行するワーカースレッドを設定します。
+	/// @param pool ワーカースレッド。nullptr の場合は、すべて呼び出し元のスレッドで実行します
+	void setWorkerPool(WorkerPool* pool) noexcept
+	{
+		m_workerPool = pool;
+	}
+
+	/// @brief 指定した位置から弾を発射します。
+	/// @param from 発射位置
+	/// @param input 弾の向きと種類
+	/// @remark step() ではプレイヤーの位置から発射します。ストレステストでは、これを使ってプレイヤーの操作とは別に弾を追加します。
+	void fire(const Vec2& from, const PlayerInput& input)
+	{
+		if (input.shot == ShotType::None)
+		{
+			return;
+		}
+
+		const Vec2 velocity = Circular{ (input.fastBullet ? FastBulletSpeed : BulletSpeed), input.angle }; // 初速
+		const double density = ((input.shot == ShotType::Light) ? 1.0 : 5.0); // 弾の密度（威力に影響）
+
+		if (input.lightBulletMode)
+		{
+			m_lightBullets.fire(from, velocity, density, m_gameClock);
+		}
+		else
+		{
+			m_bullets.fire(m_world, from, velocity, density, m_gameClock);
+		}
+	}
+
+	/// @brief 敵ユニットを追加します。
+	/// @param pos 位置
+	/// @param hp HP
+	/// @param move 上下に動くか
+	void addEnemy(const Vec2& pos, int32 hp, bool move)
+	{
+		P2Body body = m_world.createCircle(P2Kinematic, pos, Enemy::Radius, {}, EnemyUnitFilter);
+		m_enemies.add(Enemy{ std::move(body), hp, hp, move });
+	}
+
+	/// @brief シミュレーションを 1 ステップ進めます。
+	/// @param inputs このステップのすべてのプレイヤーの操作
+	void step(const PlayerInputs& inputs)
+	{
+		m_events.clear();
+		m_lightEvents.clear();
+
+		// 弾を発射する
+		for (size_t player = 0; player < PlayerCount; ++player)
+		{
+			fire(PlayerPositions[player], inputs[player]);
+		}
+
+		++m_stepCount;
+		m_gameClock += StepSec;
+
+		m_stepGraph.run(*this, m_workerPool);
+	}
+
+	/// @brief 直前のステップで発生した、弾に関する衝突イベントを返します。
+	[[nodiscard]]
+	const Array<CollisionEvent>& events() const noexcept
+	{
+		return m_events;
+	}
+
+	/// @brief ゲーム時刻を返します。
+	[[nodiscard]]
+	TimestampSec gameClock() const noexcept
+	{
+		return m_gameClock;
+	}
+
+	/// @brief 進めたステップ数を返します。
+	[[nodiscard]]
+	uint64 stepCount() const noexcept
+	{
+		return m_stepCount;
+	}
+
+	/// @brief 敵ユニットの数を返します。
+	[[nodiscard]]
+	size_t enemyCount() const noexcept
+	{
+		return m_enemies.size();
+	}
+
+	/// @brief 軽量な弾の数を返します。
+	[[nodiscard]]
+	size_t lightBulletCount() const noexcept
+	{
+		return m_lightBullets.size();
+	}
+
+	/// @brief 1 ステップの処理のタスクグラフを返します。直前のステップでのタスクごとの処理時間を調べられます。
+	[[nodiscard]]
+	const TaskGraph<Simulation>& stepGraph() const noexcept
+	{
+		return m_stepGraph;
+	}
+
+	/// @brief P2Body の弾の数を返します。
+	[[nodiscard]]
+	size_t bulletCount() const noexcept
+	{
+		return m_bullets.size();
+	}
+
+	/// @brief 状態を書き込みます。
+	/// @param state 書き込み先（前の内容は消去されます）
+	void save(Array<uint8>& state) const
+	{
+		state.clear();
+
+		StateWriter writer{ state };
+		writer.write(m_stepCount);
+		writer.write(m_gameClock);
+		m_enemies.save(writer);
+		m_bullets.save(writer);
+		m_lightBullets.save(writer);
+	}
+
+	/// @brief save() で書き込んだ状態に戻します。
+	/// @param state 状態
+	/// @return 戻せた場合 true, 状態の形式が正しくない場合は false
+	/// @remark すべての P2Body を削除して物理演算ワールドを作り直し、壁・味方ユニット・敵ユニット・弾の P2Body の順に作り直します。
+	/// false を返した場合、シミュレーションの状態は不定なので、正しい状態を load() し直してから使ってください。
+	[[nodiscard]]
+	bool load(const Array<uint8>& state)
+	{
+		// 物理演算ワールドを作り直す前に、古いワールドの P2Body をすべて手放す
+		m_enemies.clear();
+		m_bullets.clear();
+		m_walls.clear();
+		m_friendBody.release();
+		m_events.clear();
+		m_lightEvents.clear();
+
+		m_world = P2World{ 0.0 }; // 重力設定 0
+		createStaticBodies();
+
+		StateReader reader{ state };
+
+		return (reader.read(m_stepCount)
+			&& reader.read(m_gameClock)
+			&& m_enemies.load(reader, m_world)
+			&& m_bullets.load(reader, m_world)
+			&& m_lightBullets.load(reader)
+			&& reader.isEnd());
+	}
+
+	/// @brief ゲームの世界を描画します。
+	/// @param font 敵ユニットの HP のフォント
+	void draw(const Font& font) const
+	{
+		GameBounds.draw(ColorF{ 0.3 });
+
+		for (const auto& rect : WallRects)
+		{
+			rect.draw();
+		}
+
+		m_bullets.draw();
+		m_lightBullets.draw();
+		m_friendBody.draw(Palette::Yellow);
+
+		for (const auto& enemy : m_enemies)
+		{
+			enemy.draw(font);
+		}
+	}
+
+	/// @brief 状態を Print します。
+	void showStats() const
+	{
+		Print << U"gameClock: {:.2f}"_fmt(m_gameClock);
+		m_bullets.showStats();
+		m_lightBullets.showStats();
+		Print << U"enemies: {}"_fmt(m_enemies.size());
+
+		// 直前のステップでの処理ごとの時間
+		for (size_t i = 0; i < m_stepGraph.taskCount(); ++i)
+		{
+			Print << U"{}: {:.1f} us"_fmt(m_stepGraph.taskName(i), (m_stepGraph.taskNanosec()[i] / 1e3));
+		}
+	}
+
+private:
+
+	// 1 ステップの処理が読み書きするデータ
+	enum StepResource : TaskGraph<Simulation>::ResourceMask
+	{
+		// 物理演算ワールド（ブロードフェーズと接触。P2Body の位置を変更すると書き換わる）
+		WorldResource = (1 << 0),
+
+		// 弾の配列
+		BulletListResource = (1 << 1),
+
+		// 弾の P2Body の速度
+		BulletBodyResource = (1 << 2),
+
+		// 敵ユニットと、その P2Body
+		EnemyResource = (1 << 3),
+
+		// 軽量な弾
+		LightBulletResource = (1 << 4),
+
+		// 衝突イベント
+		EventResource = (1 << 5),
+
+		// 軽量な弾の衝突イベント
+		LightEventResource = (1 << 6),
+
+		// 弾が当たる敵ユニットと、それを登録した空間ハッシュ
+		EnemyGridResource = (1 << 7),
+	};
+
+	// 空気抵抗の処理で、1 つのスレッドにまとめて渡す弾の数
+	static constexpr size_t DragGrainSize = 1024;
+
+	// 1 ステップの処理のタスクグラフを作る
+	[[nodiscard]]
+	static TaskGraph<Simulation> MakeStepGraph()
+	{
+		TaskGraph<Simulation> graph;
+
+		// 移動前の位置を記録し、すべての弾に空気抵抗相当の力を与える（弾ごとに独立しているので、弾を分けて並列に処理する）
+		graph.add(U"drag", 0, (BulletListResource | BulletBodyResource),
+			[](Simulation& s, size_t begin, size_t end)
+			{
+				s.m_bullets.savePreviousPositions(begin, end);
+				s.m_bullets.applyAirResistance(StepSec, begin, end);
+			},
+			[](const Simulation& s) { return s.m_bullets.size(); }, DragGrainSize);
+
+		// 敵ユニットを移動させる
+		graph.add(U"enemy movement", 0, (EnemyResource | WorldResource),
+			[](Simulation& s, size_t, size_t) { s.moveEnemies(); });
+
+		// 2D 物理演算のワールドを更新する（すべての P2Body を書き換えるので、ほかの処理とは同時に実行しない）
+		graph.add(U"physics", 0, (WorldResource | BulletBodyResource | EnemyResource),
+			[](Simulation& s, size_t, size_t) { s.m_world.update(StepSec); });
+
+		// 弾が関わる接触から衝突イベントを作る
+		graph.add(U"collision extraction", (WorldResource | BulletListResource), EventResource,
+			[](Simulation& s, size_t, size_t) { s.extractCollisions(); });
+
+		// 弾が当たる敵ユニットを空間ハッシュに登録する
+		graph.add(U"enemy grid", EnemyResource, EnemyGridResource,
+			[](Simulation& s, size_t, size_t) { s.buildEnemyGrid(); });
+
+		// 物理演算エンジンが接触を検出しなかった速い弾について、移動の線分で壁や敵ユニットとの衝突を調べる
+		graph.add(U"swept collision", (BulletListResource | BulletBodyResource | EnemyGridResource), EventResource,
+			[](Simulation& s, size_t, size_t) { s.m_bullets.sweepFastBullets(SweepMinDistance, s.m_wallBVH, s.m_enemyTargets, s.m_enemyGrid, s.m_gameClock, s.m_events); });
+
+		// 接触した弾と、画面外に出た弾、期限切れの弾を削除する
+		graph.add(U"removal", EventResource, (WorldResource | BulletListResource | BulletBodyResource),
+			[](Simulation& s, size_t, size_t) { s.removeBullets(); });
+
+		// 軽量な弾を動かし、壁や敵ユニットに当たった弾、画面外に出た弾、期限切れの弾を削除する
+		graph.add(U"light bullets", EnemyGridResource, (LightBulletResource | LightEventResource),
+			[](Simulation& s, size_t, size_t) { s.updateLightBullets(); });
+
+		// 敵ユニットに弾によるダメージを与え、HP が 0 以下になった敵ユニットを削除する
+		graph.add(U"damage", LightEventResource, (EventResource | EnemyResource | WorldResource),
+			[](Simulation& s, size_t, size_t) { s.applyDamage(); });
+
+		return graph;
+	}
+
+	// 2D 物理演算のワールド
+	P2World m_world;
+
+	// 壁
+	Array<P2Body> m_walls;
+
+	// 弾が当たる壁を登録した境界ボリューム階層（壁は動かないので、壁の P2Body を作ったときにだけ作る）
+	StaticBVH m_wallBVH;
+
+	// 味方ユニット
+	P2Body m_friendBody;
+
+	// 敵ユニット
+	EnemyList m_enemies;
+
+	BulletList m_bullets;
+
+	// P2Body を使わない軽量な弾
+	LightBulletList m_lightBullets;
+
+	// 弾が当たる敵ユニットと、それを登録する空間ハッシュ
+	Array<CircleTarget> m_enemyTargets;
+
+	UniformGrid m_enemyGrid{ GameBounds, (Enemy::Radius * 2) };
+
+	// 直前のステップでの弾に関する衝突イベント（ステップごとに空にして使い回し、容量は減らさない）
+	Array<CollisionEvent> m_events;
+
+	// 直前のステップでの軽量な弾の衝突イベント（ステップの最後に m_events に加える）
+	Array<CollisionEvent> m_lightEvents;
+
+	// 進めたステップ数
+	uint64 m_stepCount = 0;
+
+	// ゲーム時刻
+	TimestampSec m_gameClock = 0.0;
+
+	// 1 ステップの処理
+	TaskGraph<Simulation> m_stepGraph;
+
+	// 1 ステップの処理を並列に実行するワーカースレッド
+	WorkerPool* m_workerPool = nullptr;
+
+	// 壁と味方ユニットの P2Body を作る
+	void createStaticBodies()
+	{
+		// 壁
+		Array<RectTarget> wallTargets;
+
+		for (const auto& rect : WallRects)
+		{
+			m_walls << m_world.createRect(P2Static, rect.center(), rect.size, {}, WallFilter);
+			wallTargets << RectTarget{ m_walls.back().id(), rect };
+		}
+
+		m_wallBVH = StaticBVH{ wallTargets };
+
+		// 味方ユニット
+		m_friendBody = m_world.createCircle(P2Static, FriendCircle.center, FriendCircle.r, {}, FriendUnitFilter);
+	}
+
+	void moveEnemies()
+	{
+		// enemy2 を移動させる
+		for (auto& enemy : m_enemies)
+		{
+			if (enemy.move)
+			{
+				enemy.body.setPos(enemy.body.getPos().x, Math::Sin(m_gameClock * 45_deg) * 100);
+			}
+		}
+	}
+
+	void extractCollisions()
+	{
+		// 接触イベントを取得する
+		for (auto&& [pair, collision] : m_world.getCollisions())
+		{
+			// 弾が関わらない接触はスキップする
+			if ((not m_bullets.isBullet(pair.a))
+				&& (not m_bullets.isBullet(pair.b)))
+			{
+				continue;
+			}
+
+			for (const auto& c : collision)
+			{
+				// 接触イベントを構築する
+				const CollisionEvent ce
+				{
+					.a = pair.a,
+					.b = pair.b,
+					.pos = c.point,
+					.normalImpulse = c.normalImpulse,
+					.tangentImpulse = Abs(c.tangentImpulse),
+					.timestamp = m_gameClock
+				};
+
+				// 接触イベント配列に追加する
+				m_events << ce;
+			}
+		}
+	}
+
+	void removeBullets()
+	{
+		// 接触した弾を削除する
+		for (const auto& event : m_events)
+		{
+			m_bullets.remove(event.a);
+			m_bullets.remove(event.b);
+		}
+
+		// 画面外に出た弾と、発射から BulletLifetimeSec 秒以上経過した弾をまとめて削除する
+		m_bullets.removeExpired(GameBounds, (m_gameClock - BulletLifetimeSec));
+	}
+
+	void buildEnemyGrid()
+	{
+		m_enemyTargets.clear();
+
+		for (const auto& enemy : m_enemies)
+		{
+			m_enemyTargets << CircleTarget{ enemy.body.id(), Circle{ enemy.body.getPos(), Enemy::Radius } };
+		}
+
+		m_enemyGrid.build(m_enemyTargets);
+	}
+
+	void updateLightBullets()
+	{
+		if (m_lightBullets.isEmpty())
+		{
+			return;
+		}
+
+		m_lightBullets.update(StepSec, GameBounds, (m_gameClock - BulletLifetimeSec), m_wallBVH, m_enemyTargets, m_enemyGrid, m_gameClock, m_lightEvents);
+	}
+
+	void applyDamage()
+	{
+		// 軽量な弾の衝突イベントは、P2Body の弾の衝突イベントの後ろに加える
+		m_events.insert(m_events.end(), m_lightEvents.begin(), m_lightEvents.end());
+
+		m_enemies.applyDamage(m_events);
+	}
+};
+
+/// @brief 自動で操作するプレイヤーの、指定したステップでの操作を返します。
+/// @param step ステップ
+/// @param player プレイヤーの番号
+/// @return 操作
+/// @remark 右に向かって首を振りながら、0.2 秒ごとに軽い弾と重い弾を交互に撃ちます。同じステップとプレイヤーに対しては、常に同じ操作を返します。
+[[nodiscard]]
+inline PlayerInput MakeAutoInput(uint64 step, size_t player)
+{
+	constexpr uint64 FireInterval = 40;
+
+	const double t = (step * Simulation::StepSec);
+
+	PlayerInput input;
+	input.angle = (90_deg + Math::Sin((t + player) * 60_deg) * 30_deg);
+
+	if ((step % FireInterval) == 0)
+	{
+		input.shot = (((step / FireInterval) % 2) ? ShotType::Heavy : ShotType::Light);
+	}
+
+	return input;
+}
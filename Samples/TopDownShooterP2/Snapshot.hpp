@@ -0,0 +1,427 @@
+# pragma once
+# include <Siv3D.hpp>
+# include <cstring>
+
+/// @brief シミュレーションの状態をバイト列に書き込むクラス
+/// @remark 値はメモリ上の表現のまま書き込むので、浮動小数点数も含めてビット単位で同じ値に戻せます。
+/// 同じプログラムの中で保存・復元するためのもので、異なる環境の間での互換性はありません。
+class StateWriter
+{
+public:
+
+	/// @brief 指定したバイト列の末尾に書き込むクラスを作成します。
+	/// @param data 書き込み先
+	explicit StateWriter(Array<uint8>& data)
+		: m_data{ data } {}
+
+	/// @brief 値を書き込みます。
+	/// @remark 構造体のパディングには不定な値が入るので、構造体は書き込まずに、メンバを 1 つずつ書き込みます。
+	template <class Type>
+	void write(const Type& value)
+	{
+		static_assert(std::is_arithmetic_v<Type> || std::is_same_v<Type, Vec2>);
+		append(&value, sizeof(Type));
+	}
+
+	/// @brief 要素数と、要素の配列を書き込みます。
+	template <class Type>
+	void writeArray(const Array<Type>& values)
+	{
+		static_assert(std::is_arithmetic_v<Type>);
+		write(static_cast<uint64>(values.size()));
+		append(values.data(), (sizeof(Type) * values.size()));
+	}
+
+private:
+
+	Array<uint8>& m_data;
+
+	void append(const void* p, size_t size)
+	{
+		const size_t offset = m_data.size();
+		m_data.resize(offset + size);
+		std::memcpy((m_data.data() + offset), p, size);
+	}
+};
+
+/// @brief StateWriter で書き込んだバイト列から状態を読み込むクラス
+class StateReader
+{
+public:
+
+	/// @brief 指定したバイト列の先頭から読み込むクラスを作成します。
+	/// @param data 読み込むバイト列
+	explicit StateReader(const Array<uint8>& data)
+		: m_data{ data } {}
+
+	/// @brief 値を読み込みます。
+	/// @return 読み込めた場合 true, データが途中で終わっている場合は false
+	template <class Type>
+	[[nodiscard]]
+	bool read(Type& value)
+	{
+		static_assert(std::is_arithmetic_v<Type> || std::is_same_v<Type, Vec2>);
+		return extract(&value, sizeof(Type));
+	}
+
+	/// @brief 要素数と、要素の配列を読み込みます。
+	/// @return 読み込めた場合 true, データが途中で終わっている場合は false
+	template <class Type>
+	[[nodiscard]]
+	bool readArray(Array<Type>& values)
+	{
+		static_assert(std::is_arithmetic_v<Type>);
+
+		uint64 size;
+
+		if ((not read(size)) || (((m_data.size() - m_offset) / sizeof(Type)) < size))
+		{
+			return false;
+		}
+
+		values.resize(static_cast<size_t>(size));
+		return extract(values.data(), (sizeof(Type) * values.size()));
+	}
+
+	/// @brief すべてのデータを読み終えたかを返します。
+	[[nodiscard]]
+	bool isEnd() const noexcept
+	{
+		return (m_offset == m_data.size());
+	}
+
+private:
+
+	const Array<uint8>& m_data;
+
+	size_t m_offset = 0;
+
+	bool extract(void* p, size_t size)
+	{
+		if ((m_data.size() - m_offset) < size)
+		{
+			return false;
+		}
+
+		if (size != 0)
+		{
+			std::memcpy(p, (m_data.data() + m_offset), size);
+		}
+
+		m_offset += size;
+		return true;
+	}
+};
+
+namespace SnapshotDetail
+{
+	// 可変長整数 (LEB128) を書き込む
+	inline void WriteVarint(Array<uint8>& data, uint64 value)
+	{
+		while (0x80 <= value)
+		{
+			data << static_cast<uint8>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+
+		data << static_cast<uint8>(value);
+	}
+
+	// 可変長整数 (LEB128) を読み込む。データが途中で終わっている場合や 64 ビットに収まらない場合は false を返す
+	inline bool ReadVarint(const Array<uint8>& data, size_t& offset, uint64& value)
+	{
+		value = 0;
+
+		for (int32 shift = 0; shift < 64; shift += 7)
+		{
+			if (data.size() <= offset)
+			{
+				return false;
+			}
+
+			const uint8 byte = data[offset++];
+
+			// 10 バイト目は最下位ビットしか 64 ビットに収まらない
+			if ((shift == 63) && ((byte & 0x7E) != 0))
+			{
+				return false;
+			}
+
+			value |= (static_cast<uint64>(byte & 0x7F) << shift);
+
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+/// @brief 前の状態との差分を書き込みます。
+/// @param previous 前の状態
+/// @param current 現在の状態
+/// @param delta 差分の書き込み先（前の内容は消去されます）
+/// @remark 2 つの状態の XOR を取り、0 が続く部分を詰めます。形式は、現在の状態のバイト数 (LEB128) の後に、
+/// 「0 のバイトの個数 (LEB128)」「0 以外を含むバイトの個数 (LEB128)」「そのバイト列」の繰り返しです。前の状態が短い場合は、足りない部分を 0 として扱います。
+inline void EncodeDelta(const Array<uint8>& previous, const Array<uint8>& current, Array<uint8>& delta)
+{
+	// これより短い 0 の並びは、0 以外のバイト列に含めたほうが短くなる
+	constexpr size_t MinZeroRun = 4;
+
+	delta.clear();
+	SnapshotDetail::WriteVarint(delta, current.size());
+
+	const auto xorAt = [&](size_t i) -> uint8
+		{
+			return static_cast<uint8>(current[i] ^ ((i < previous.size()) ? previous[i] : 0));
+		};
+
+	size_t i = 0;
+
+	while (i < current.size())
+	{
+		const size_t zeroBegin = i;
+
+		while ((i < current.size()) && (xorAt(i) == 0))
+		{
+			++i;
+		}
+
+		// 0 が MinZeroRun 個以上続くところまでを 0 以外のバイト列とする
+		const size_t literalBegin = i;
+		size_t zeroCount = 0;
+
+		while ((i < current.size()) && (zeroCount < MinZeroRun))
+		{
+			zeroCount = ((xorAt(i) == 0) ? (zeroCount + 1) : 0);
+			++i;
+		}
+
+		const size_t literalEnd = (i - zeroCount);
+		i = literalEnd;
+
+		SnapshotDetail::WriteVarint(delta, (literalBegin - zeroBegin));
+		SnapshotDetail::WriteVarint(delta, (literalEnd - literalBegin));
+
+		for (size_t k = literalBegin; k < literalEnd; ++k)
+		{
+			delta << xorAt(k);
+		}
+	}
+}
+
+/// @brief 前の状態と差分から、現在の状態を復元します。
+/// @param previous 前の状態
+/// @param delta EncodeDelta() で書き込んだ差分
+/// @param current 現在の状態の書き込み先
+/// @return 復元できた場合 true, 差分の形式が正しくない場合は false
+inline bool DecodeDelta(const Array<uint8>& previous, const Array<uint8>& delta, Array<uint8>& current)
+{
+	size_t offset = 0;
+	uint64 size;
+
+	if ((not SnapshotDetail::ReadVarint(delta, offset, size)) || (Largest<size_t> < size))
+	{
+		return false;
+	}
+
+	current.resize(static_cast<size_t>(size));
+
+	// 前の状態をそのまま写してから、差分のあるバイトだけを XOR する
+	const size_t common = Min(previous.size(), current.size());
+
+	if (common != 0)
+	{
+		std::memcpy(current.data(), previous.data(), common);
+	}
+
+	std::fill((current.begin() + common), current.end(), 0);
+
+	size_t i = 0;
+
+	while (i < current.size())
+	{
+		uint64 zeroCount, literalCount;
+
+		if ((not SnapshotDetail::ReadVarint(delta, offset, zeroCount)) || (not SnapshotDetail::ReadVarint(delta, offset, literalCount))
+			|| ((current.size() - i) < zeroCount) || ((current.size() - i - zeroCount) < literalCount)
+			|| ((delta.size() - offset) < literalCount))
+		{
+			return false;
+		}
+
+		i += static_cast<size_t>(zeroCount);
+
+		for (uint64 k = 0; k < literalCount; ++k)
+		{
+			current[i++] ^= delta[offset++];
+		}
+	}
+
+	return (offset == delta.size());
+}
+
+/// @brief 状態のチェックサムを返します。
+/// @param state 状態
+/// @return チェックサム (64 ビットの FNV-1a)
+/// @remark 通信相手と状態を比べるために使います。衝突に強いハッシュではありません。
+[[nodiscard]]
+inline uint64 StateChecksum(const Array<uint8>& state) noexcept
+{
+	uint64 hash = 0xcbf2'9ce4'8422'2325;
+
+	for (const uint8 byte : state)
+	{
+		hash = ((hash ^ byte) * 0x0000'0100'0000'01b3);
+	}
+
+	return hash;
+}
+
+/// @brief 毎ステップの状態を差分で保存しておき、直近の任意のステップの状態を復元できる履歴
+/// @remark KeyframeInterval ステップごとに状態をそのまま保存し（キーフレーム）、その間のステップは 1 つ前のステップとの差分 (EncodeDelta()) だけを保存します。
+/// 古いものから上書きするリングバッファで、各エントリのバッファは容量を減らさずに使い回すので、一巡した後は、状態が大きくならない限り保存してもメモリ確保が起こりません。
+class SnapshotHistory
+{
+public:
+
+	/// @brief キーフレームを保存する間隔（ステップ）
+	static constexpr uint64 KeyframeInterval = 30;
+
+	SnapshotHistory() = default;
+
+	/// @brief 履歴を作成します。
+	/// @param capacity 保存しておくステップ数
+	explicit SnapshotHistory(size_t capacity)
+		: m_entries(Max<size_t>(capacity, 1)) {}
+
+	/// @brief 指定したステップの状態を保存します。
+	/// @param step ステップ
+	/// @param state 状態
+	/// @remark 直前に保存（または復元）したステップの次のステップであれば差分を、そうでなければキーフレームを保存します。
+	/// 保存したステップより後のステップの履歴は無効になります。
+	void push(uint64 step, const Array<uint8>& state)
+	{
+		Entry& entry = m_entries[step % m_entries.size()];
+		entry.step = step;
+		entry.keyframe = ((step % KeyframeInterval) == 0) || (m_latestStep != (step - 1)) || (not m_hasLatest);
+
+		if (entry.keyframe)
+		{
+			entry.data = state;
+		}
+		else
+		{
+			EncodeDelta(m_latestState, state, entry.data);
+		}
+
+		m_latestState = state;
+		m_latestStep = step;
+		m_hasLatest = true;
+	}
+
+	/// @brief 指定したステップの状態を復元します。
+	/// @param step ステップ
+	/// @param state 状態の書き込み先
+	/// @return 復元できた場合 true, そのステップの履歴が無い場合は false
+	/// @remark 復元したステップより後のステップの履歴は無効になり、次の push() ではそのステップの次のステップとの差分を保存できます。
+	[[nodiscard]]
+	bool restore(uint64 step, Array<uint8>& state)
+	{
+		if ((not contains(step)))
+		{
+			return false;
+		}
+
+		if (step != m_latestStep)
+		{
+			// キーフレームまで遡り、そこから差分を順に適用する
+			uint64 keyframeStep = step;
+
+			while (not m_entries[keyframeStep % m_entries.size()].keyframe)
+			{
+				if ((keyframeStep == 0) || (not contains(keyframeStep - 1)))
+				{
+					return false;
+				}
+
+				--keyframeStep;
+			}
+
+			m_latestState = m_entries[keyframeStep % m_entries.size()].data;
+
+			for (uint64 s = (keyframeStep + 1); s <= step; ++s)
+			{
+				if (not DecodeDelta(m_latestState, m_entries[s % m_entries.size()].data, m_scratch))
+				{
+					return false;
+				}
+
+				std::swap(m_latestState, m_scratch);
+			}
+
+			m_latestStep = step;
+		}
+
+		state = m_latestState;
+		return true;
+	}
+
+	/// @brief 指定したステップの状態を復元できるかを返します。
+	/// @remark キーフレームが上書きされていると、その後の差分だけが残っていても復元できません。
+	[[nodiscard]]
+	bool contains(uint64 step) const noexcept
+	{
+		return (m_hasLatest && (step <= m_latestStep) && (m_entries[step % m_entries.size()].step == step));
+	}
+
+	/// @brief 保存している差分とキーフレームの合計のバイト数を返します。
+	[[nodiscard]]
+	size_t byteSize() const noexcept
+	{
+		size_t size = 0;
+
+		for (const auto& entry : m_entries)
+		{
+			if (contains(entry.step))
+			{
+				size += entry.data.size();
+			}
+		}
+
+		return size;
+	}
+
+	/// @brief 最後に保存した状態の、差分またはキーフレームのバイト数を返します。
+	[[nodiscard]]
+	size_t latestByteSize() const noexcept
+	{
+		return (m_hasLatest ? m_entries[m_latestStep % m_entries.size()].data.size() : 0);
+	}
+
+private:
+
+	struct Entry
+	{
+		uint64 step = Largest<uint64>;
+
+		bool keyframe = false;
+
+		// キーフレームであれば状態そのもの、そうでなければ 1 つ前のステップとの差分
+		Array<uint8> data;
+	};
+
+	Array<Entry> m_entries = Array<Entry>(1);
+
+	// 最後に保存（または復元）したステップと、その状態
+	uint64 m_latestStep = 0;
+
+	bool m_hasLatest = false;
+
+	Array<uint8> m_latestState;
+
+	// 差分を復元するときの作業用のバッファ
+	Array<uint8> m_scratch;
+};
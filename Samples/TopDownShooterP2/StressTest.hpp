@@ -0,0 +1,350 @@
+# pragma once
+# include <Siv3D.hpp>
+# include "Simulation.hpp"
+# include "TaskGraph.hpp"
+
+/// @brief ストレステストの設定
+/// @remark 波ごとに敵ユニットを追加し、撃つ弾の数を増やしていきます。波 w (0 から数える) では、敵ユニットを enemiesPerWave * (w + 1) 体追加し、
+/// 各プレイヤーが 1 ステップに shotsPerStep * (w + 1) 発の弾を扇状に撃ちます。
+struct StressTestConfig
+{
+	/// @brief 波の数
+	int32 waveCount = 8;
+
+	/// @brief 1 つの波のステップ数
+	int32 stepsPerWave = 400;
+
+	/// @brief 最初の波で追加する敵ユニットの数
+	int32 enemiesPerWave = 8;
+
+	/// @brief 追加する敵ユニットの HP
+	int32 enemyHP = 3000;
+
+	/// @brief 追加する敵ユニットのうち、上下に動くものの割合
+	double movingEnemyRatio = 0.25;
+
+	/// @brief 最初の波で、各プレイヤーが 1 ステップに撃つ弾の数
+	int32 shotsPerStep = 1;
+
+	/// @brief 扇状に撃つ弾の広がり（ラジアン）
+	double spreadAngle = 60_deg;
+
+	/// @brief P2Body を使わない軽量な弾を撃つか
+	bool lightBulletMode = false;
+
+	/// @brief 初速の速い弾を撃つか
+	bool fastBullet = false;
+
+	/// @brief 敵ユニットの配置の乱数のシード
+	uint64 seed = 12345;
+};
+
+/// @brief ストレステストの、1 つの処理の時間の統計
+struct StressStageStats
+{
+	/// @brief 処理の名前
+	String name;
+
+	/// @brief 平均（マイクロ秒）
+	double meanMicrosec = 0.0;
+
+	/// @brief 中央値（マイクロ秒）
+	double p50Microsec = 0.0;
+
+	/// @brief 90 パーセンタイル（マイクロ秒）
+	double p90Microsec = 0.0;
+
+	/// @brief 99 パーセンタイル（マイクロ秒）
+	double p99Microsec = 0.0;
+
+	/// @brief 最大値（マイクロ秒）
+	double maxMicrosec = 0.0;
+
+	/// @brief ヒストグラム。i 番目の要素は、[StressHistogramBucketMin(i), StressHistogramBucketMin(i + 1)) マイクロ秒だったステップの数
+	Array<uint32> histogram;
+};
+
+/// @brief ストレステストの、1 つの波の結果
+struct StressWaveReport
+{
+	/// @brief 波の番号
+	int32 wave = 0;
+
+	/// @brief 波の最後の敵ユニットの数
+	size_t enemyCount = 0;
+
+	/// @brief 波の間の P2Body の弾の数の平均
+	double averageBulletCount = 0.0;
+
+	/// @brief 波の間の軽量な弾の数の平均
+	double averageLightBulletCount = 0.0;
+
+	/// @brief 処理ごとの時間の統計。最後の要素は 1 ステップ全体
+	Array<StressStageStats> stages;
+};
+
+/// @brief ストレステストの結果
+struct StressReport
+{
+	StressTestConfig config;
+
+	/// @brief ワーカースレッドの数
+	size_t threadCount = 0;
+
+	Array<StressWaveReport> waves;
+};
+
+/// @brief ヒストグラムの区間の数
+inline constexpr size_t StressHistogramBucketCount = 24;
+
+/// @brief ヒストグラムの i 番目の区間の下限（マイクロ秒）を返します。区間は 0, 1, 2, 4, 8, ... マイクロ秒で区切ります。
+[[nodiscard]]
+inline constexpr uint64 StressHistogramBucketMin(size_t i) noexcept
+{
+	return ((i == 0) ? 0 : (uint64{ 1 } << (i - 1)));
+}
+
+namespace StressTestDetail
+{
+	// 処理時間（ナノ秒）が入るヒストグラムの区間を返す
+	[[nodiscard]]
+	inline size_t StressHistogramBucket(uint64 nanosec) noexcept
+	{
+		size_t i = 0;
+
+		for (uint64 microsec = (nanosec / 1000); (microsec != 0) && (i < (StressHistogramBucketCount - 1)); microsec >>= 1)
+		{
+			++i;
+		}
+
+		return i;
+	}
+
+	// 処理時間（ナノ秒）の列から統計を作る
+	[[nodiscard]]
+	inline StressStageStats MakeStressStageStats(StringView name, Array<uint64>& samples)
+	{
+		StressStageStats stats;
+		stats.name = name;
+		stats.histogram.assign(StressHistogramBucketCount, 0);
+
+		if (samples.isEmpty())
+		{
+			return stats;
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		const auto percentile = [&](double p)
+			{
+				const size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+				return (samples[Clamp<size_t>(rank, 1, samples.size()) - 1] / 1e3);
+			};
+
+		uint64 sum = 0;
+
+		for (const uint64 sample : samples)
+		{
+			sum += sample;
+			++stats.histogram[StressHistogramBucket(sample)];
+		}
+
+		stats.meanMicrosec = (sum / 1e3 / samples.size());
+		stats.p50Microsec = percentile(0.5);
+		stats.p90Microsec = percentile(0.9);
+		stats.p99Microsec = percentile(0.99);
+		stats.maxMicrosec = (samples.back() / 1e3);
+
+		return stats;
+	}
+}
+
+/// @brief 敵ユニットの波と自動の射撃で負荷を上げながらシミュレーションし、ステップごとの処理の時間を記録します。
+/// @param config 設定
+/// @param pool 1 ステップの処理を並列に実行するワーカースレッド。nullptr の場合は、すべて呼び出し元のスレッドで実行します
+/// @return 結果
+/// @remark 描画はせず、シミュレーションだけを行います。同じ設定であれば、毎回同じ状態の列をたどります。
+inline StressReport RunStressTest(const StressTestConfig& config, WorkerPool* pool)
+{
+	// 敵ユニットを配置する範囲（壁の間の、プレイヤーより右）
+	constexpr RectF SpawnArea{ 0, -150, 350, 300 };
+
+	StressReport report;
+	report.config = config;
+	report.threadCount = (pool ? pool->threadCount() : 0);
+
+	DefaultRNG rng{ config.seed };
+	Simulation simulation;
+	simulation.setWorkerPool(pool);
+
+	const TaskGraph<Simulation>& graph = simulation.stepGraph();
+	const size_t stageCount = (graph.taskCount() + 1);
+
+	// 処理ごとの、各ステップの時間（ナノ秒）
+	Array<Array<uint64>> samples(stageCount);
+
+	for (int32 wave = 0; wave < config.waveCount; ++wave)
+	{
+		for (int32 i = 0; i < (config.enemiesPerWave * (wave + 1)); ++i)
+		{
+			const Vec2 pos = RandomVec2(SpawnArea, rng);
+			simulation.addEnemy(pos, config.enemyHP, RandomBool(config.movingEnemyRatio, rng));
+		}
+
+		for (auto& stageSamples : samples)
+		{
+			stageSamples.clear();
+		}
+
+		const int32 shotCount = (config.shotsPerStep * (wave + 1));
+		size_t bulletCountSum = 0, lightBulletCountSum = 0;
+
+		for (int32 i = 0; i < config.stepsPerWave; ++i)
+		{
+			const uint64 step = simulation.stepCount();
+			const uint64 start = Time::GetNanosec();
+
+			// 各プレイヤーが、首を振りながら扇状に弾を撃つ
+			for (size_t player = 0; player < Simulation::PlayerCount; ++player)
+			{
+				PlayerInput input = MakeAutoInput(step, player);
+				const double centerAngle = input.angle;
+				input.lightBulletMode = config.lightBulletMode;
+				input.fastBullet = config.fastBullet;
+
+				for (int32 k = 0; k < shotCount; ++k)
+				{
+					input.angle = (centerAngle + config.spreadAngle * ((shotCount == 1) ? 0.0 : ((static_cast<double>(k) / (shotCount - 1)) - 0.5)));
+					input.shot = (((step + k) % 2) ? ShotType::Heavy : ShotType::Light);
+					simulation.fire(Simulation::PlayerPositions[player], input);
+				}
+			}
+
+			simulation.step(Simulation::PlayerInputs{});
+
+			samples.back() << (Time::GetNanosec() - start);
+
+			for (size_t taskIndex = 0; taskIndex < graph.taskCount(); ++taskIndex)
+			{
+				samples[taskIndex] << graph.taskNanosec()[taskIndex];
+			}
+
+			bulletCountSum += simulation.bulletCount();
+			lightBulletCountSum += simulation.lightBulletCount();
+		}
+
+		StressWaveReport waveReport;
+		waveReport.wave = wave;
+		waveReport.enemyCount = simulation.enemyCount();
+		waveReport.averageBulletCount = (static_cast<double>(bulletCountSum) / Max(config.stepsPerWave, 1));
+		waveReport.averageLightBulletCount = (static_cast<double>(lightBulletCountSum) / Max(config.stepsPerWave, 1));
+
+		for (size_t stage = 0; stage < stageCount; ++stage)
+		{
+			waveReport.stages << StressTestDetail::MakeStressStageStats(((stage < graph.taskCount()) ? graph.taskName(stage) : U"step"), samples[stage]);
+		}
+
+		report.waves << std::move(waveReport);
+	}
+
+	return report;
+}
+
+/// @brief ストレステストの結果の、波と処理ごとの統計を CSV で保存します。
+/// @param report 結果
+/// @param path 保存先
+/// @return 保存できた場合 true, それ以外の場合は false
+inline bool SaveStressSummaryCSV(const StressReport& report, FilePathView path)
+{
+	CSV csv;
+	csv.writeRow(U"wave", U"enemies", U"bullets", U"light bullets", U"stage", U"mean [us]", U"p50 [us]", U"p90 [us]", U"p99 [us]", U"max [us]");
+
+	for (const auto& wave : report.waves)
+	{
+		for (const auto& stage : wave.stages)
+		{
+			csv.writeRow(wave.wave, wave.enemyCount, wave.averageBulletCount, wave.averageLightBulletCount, stage.name,
+				stage.meanMicrosec, stage.p50Microsec, stage.p90Microsec, stage.p99Microsec, stage.maxMicrosec);
+		}
+	}
+
+	return csv.save(path);
+}
+
+/// @brief ストレステストの結果の、波と処理ごとのヒストグラムを CSV で保存します。
+/// @param report 結果
+/// @param path 保存先
+/// @return 保存できた場合 true, それ以外の場合は false
+inline bool SaveStressHistogramCSV(const StressReport& report, FilePathView path)
+{
+	CSV csv;
+	csv.writeRow(U"wave", U"stage", U"min [us]", U"max [us]", U"steps");
+
+	for (const auto& wave : report.waves)
+	{
+		for (const auto& stage : wave.stages)
+		{
+			for (size_t i = 0; i < stage.histogram.size(); ++i)
+			{
+				csv.writeRow(wave.wave, stage.name, StressHistogramBucketMin(i), StressHistogramBucketMin(i + 1), stage.histogram[i]);
+			}
+		}
+	}
+
+	return csv.save(path);
+}
+
+/// @brief ストレステストの設定と結果を JSON で保存します。
+/// @param report 結果
+/// @param path 保存先
+/// @return 保存できた場合 true, それ以外の場合は false
+inline bool SaveStressReportJSON(const StressReport& report, FilePathView path)
+{
+	JSON json;
+	json[U"config"][U"waveCount"] = report.config.waveCount;
+	json[U"config"][U"stepsPerWave"] = report.config.stepsPerWave;
+	json[U"config"][U"enemiesPerWave"] = report.config.enemiesPerWave;
+	json[U"config"][U"enemyHP"] = report.config.enemyHP;
+	json[U"config"][U"movingEnemyRatio"] = report.config.movingEnemyRatio;
+	json[U"config"][U"shotsPerStep"] = report.config.shotsPerStep;
+	json[U"config"][U"spreadAngle"] = report.config.spreadAngle;
+	json[U"config"][U"lightBulletMode"] = report.config.lightBulletMode;
+	json[U"config"][U"fastBullet"] = report.config.fastBullet;
+	json[U"config"][U"seed"] = report.config.seed;
+	json[U"threadCount"] = report.threadCount;
+
+	Array<uint64> bucketMins;
+
+	for (size_t i = 0; i < StressHistogramBucketCount; ++i)
+	{
+		bucketMins << StressHistogramBucketMin(i);
+	}
+
+	json[U"histogramBucketMinMicrosec"] = bucketMins;
+
+	for (const auto& wave : report.waves)
+	{
+		JSON waveJSON;
+		waveJSON[U"wave"] = wave.wave;
+		waveJSON[U"enemies"] = wave.enemyCount;
+		waveJSON[U"bullets"] = wave.averageBulletCount;
+		waveJSON[U"lightBullets"] = wave.averageLightBulletCount;
+
+		for (const auto& stage : wave.stages)
+		{
+			JSON stageJSON;
+			stageJSON[U"name"] = stage.name;
+			stageJSON[U"meanMicrosec"] = stage.meanMicrosec;
+			stageJSON[U"p50Microsec"] = stage.p50Microsec;
+			stageJSON[U"p90Microsec"] = stage.p90Microsec;
+			stageJSON[U"p99Microsec"] = stage.p99Microsec;
+			stageJSON[U"maxMicrosec"] = stage.maxMicrosec;
+			stageJSON[U"histogram"] = stage.histogram;
+			waveJSON[U"stages"].push_back(stageJSON);
+		}
+
+		json[U"waves"].push_back(waveJSON);
+	}
+
+	return json.save(path);
+}
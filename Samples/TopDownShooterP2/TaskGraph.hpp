@@ -0,0 +1,358 @@
+# pragma once
+# include <Siv3D.hpp>
+# include <atomic>
+# include <condition_variable>
+# include <mutex>
+# include <thread>
+
+/// @brief 常駐するワーカースレッドで、番号ごとに独立した処理を並列に行うクラス
+/// @remark 1 ステップ（5 ミリ秒）に何度も使うので、呼び出しのたびにスレッドを作る Async の代わりに、スレッドを作っておいて待機させます。
+/// 呼び出し元のスレッドも処理に加わります。同時に複数のスレッドから使うことはできません。
+class WorkerPool
+{
+public:
+
+	/// @brief ワーカースレッドを作成します。
+	/// @param threadCount ワーカースレッドの数（呼び出し元のスレッドも処理に加わるので、0 の場合はすべて呼び出し元のスレッドで処理します）
+	/// @remark Web 版ではスレッドを作らず、常にすべて呼び出し元のスレッドで処理します。
+	explicit WorkerPool([[maybe_unused]] size_t threadCount)
+	{
+	# if SIV3D_PLATFORM(WEB)
+
+		// Web 版ではスレッドを作らない
+
+	# else
+
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			m_threads.emplace_back([this]() { work(); });
+		}
+
+	# endif
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+
+	WorkerPool& operator =(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard lock{ m_mutex };
+			m_stop = true;
+		}
+
+		m_jobPosted.notify_all();
+
+		for (auto& thread : m_threads)
+		{
+			thread.join();
+		}
+	}
+
+	/// @brief ワーカースレッドの数を返します。
+	[[nodiscard]]
+	size_t threadCount() const noexcept
+	{
+		return m_threads.size();
+	}
+
+	/// @brief 0 から (count - 1) までの番号について f(番号) を並列に呼び、すべて終わるまで待ちます。
+	/// @param count 番号の数
+	/// @param f 処理。異なる番号の処理は、同時に異なるスレッドで呼ばれます
+	template <class Fty>
+	void parallelFor(size_t count, Fty&& f)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		if ((count == 1) || m_threads.empty())
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				f(i);
+			}
+
+			return;
+		}
+
+		{
+			std::unique_lock lock{ m_mutex };
+
+			// 前の処理に遅れて起きたワーカースレッドが、前の処理の番号を取り終えるまで待つ
+			m_jobFinished.wait(lock, [this]() { return (m_activeCount == 0); });
+
+			m_job = [](void* context, size_t index) { (*static_cast<std::remove_reference_t<Fty>*>(context))(index); };
+			m_context = &f;
+			m_count = count;
+			m_next.store(0, std::memory_order_relaxed);
+			m_finished.store(0, std::memory_order_relaxed);
+			++m_generation;
+		}
+
+		m_jobPosted.notify_all();
+
+		runJob(m_job, m_context, count);
+
+		std::unique_lock lock{ m_mutex };
+		m_jobFinished.wait(lock, [this]() { return ((m_finished.load(std::memory_order_acquire) == m_count) && (m_activeCount == 0)); });
+	}
+
+private:
+
+	Array<std::thread> m_threads;
+
+	std::mutex m_mutex;
+
+	// 処理が追加されたことをワーカースレッドに知らせる
+	std::condition_variable m_jobPosted;
+
+	// 処理が終わったことを呼び出し元のスレッドに知らせる
+	std::condition_variable m_jobFinished;
+
+	// 以下は m_mutex で保護する
+	void (*m_job)(void*, size_t) = nullptr;
+
+	void* m_context = nullptr;
+
+	size_t m_count = 0;
+
+	uint64 m_generation = 0;
+
+	size_t m_activeCount = 0;
+
+	bool m_stop = false;
+
+	// 次に処理する番号と、処理し終えた番号の数
+	std::atomic<size_t> m_next{ 0 };
+
+	std::atomic<size_t> m_finished{ 0 };
+
+	void work()
+	{
+		uint64 generation = 0;
+
+		for (;;)
+		{
+			void (*job)(void*, size_t);
+			void* context;
+			size_t count;
+
+			{
+				std::unique_lock lock{ m_mutex };
+				m_jobPosted.wait(lock, [&]() { return (m_stop || (m_generation != generation)); });
+
+				if (m_stop)
+				{
+					return;
+				}
+
+				generation = m_generation;
+				job = m_job;
+				context = m_context;
+				count = m_count;
+				++m_activeCount;
+			}
+
+			runJob(job, context, count);
+
+			{
+				std::lock_guard lock{ m_mutex };
+				--m_activeCount;
+			}
+
+			m_jobFinished.notify_all();
+		}
+	}
+
+	void runJob(void (*job)(void*, size_t), void* context, size_t count)
+	{
+		for (size_t index; (index = m_next.fetch_add(1, std::memory_order_relaxed)) < count;)
+		{
+			job(context, index);
+			m_finished.fetch_add(1, std::memory_order_release);
+		}
+	}
+};
+
+/// @brief 各タスクが読み書きする資源から依存関係を決め、互いに依存しないタスクを並列に実行するタスクグラフ
+/// @tparam Context タスクが処理する対象の型
+/// @remark 後から追加したタスクは、先に追加したタスクのうち、一方が書き込む資源を他方が読み書きするものがすべて終わってから実行します。
+/// タスクは依存の深さごとの段に分け、段ごとに WorkerPool で並列に実行します。要素数を返す関数を指定したタスクは、要素を grainSize 個ずつに分けて並列に処理します。
+/// 同じ段のタスクは互いに独立しているので、並列に実行しても、追加した順に 1 つずつ実行しても結果は同じになります。
+/// 直前の run() でのタスクごとの処理時間を記録しておくので、どの処理が重いかを調べられます。
+template <class Context>
+class TaskGraph
+{
+public:
+
+	/// @brief 資源の集合（資源ごとに 1 ビット）
+	using ResourceMask = uint32;
+
+	/// @brief タスクの処理。[begin, end) の範囲の要素を処理する（要素数を返す関数を指定しないタスクでは [0, 1)）
+	using TaskFunction = void(*)(Context&, size_t begin, size_t end);
+
+	/// @brief タスクが処理する要素数を返す関数
+	using ItemCountFunction = size_t(*)(const Context&);
+
+	/// @brief タスクを追加します。
+	/// @param name タスクの名前
+	/// @param reads 読み込む資源
+	/// @param writes 書き込む資源
+	/// @param function 処理
+	/// @param itemCount 要素を分けて並列に処理する場合、要素数を返す関数
+	/// @param grainSize 1 回の処理に渡す要素数
+	void add(StringView name, ResourceMask reads, ResourceMask writes, TaskFunction function, ItemCountFunction itemCount = nullptr, size_t grainSize = 1)
+	{
+		size_t stage = 0;
+
+		for (const auto& task : m_tasks)
+		{
+			if ((task.writes & (reads | writes)) || (task.reads & writes))
+			{
+				stage = Max(stage, (task.stage + 1));
+			}
+		}
+
+		m_tasks << Task{ name, reads, writes, function, itemCount, Max<size_t>(grainSize, 1), stage };
+		m_taskNanosec << 0;
+		m_stageCount = Max(m_stageCount, (stage + 1));
+	}
+
+	/// @brief すべてのタスクを実行します。
+	/// @param context タスクが処理する対象
+	/// @param pool ワーカースレッド。nullptr の場合は、すべて呼び出し元のスレッドで実行します
+	void run(Context& context, WorkerPool* pool)
+	{
+		std::fill(m_taskNanosec.begin(), m_taskNanosec.end(), 0);
+
+		for (size_t stage = 0; stage < m_stageCount; ++stage)
+		{
+			m_workItems.clear();
+
+			for (size_t taskIndex = 0; taskIndex < m_tasks.size(); ++taskIndex)
+			{
+				const Task& task = m_tasks[taskIndex];
+
+				if (task.stage != stage)
+				{
+					continue;
+				}
+
+				const size_t itemCount = (task.itemCount ? task.itemCount(context) : 1);
+
+				for (size_t begin = 0; begin < itemCount; begin += task.grainSize)
+				{
+					m_workItems << WorkItem{ task.function, taskIndex, begin, Min((begin + task.grainSize), itemCount) };
+				}
+			}
+
+			if (pool)
+			{
+				pool->parallelFor(m_workItems.size(), [&](size_t i) { m_workItems[i].run(context); });
+			}
+			else
+			{
+				for (auto& workItem : m_workItems)
+				{
+					workItem.run(context);
+				}
+			}
+
+			for (const auto& workItem : m_workItems)
+			{
+				m_taskNanosec[workItem.taskIndex] += workItem.nanosec;
+			}
+		}
+	}
+
+	/// @brief タスクの数を返します。
+	[[nodiscard]]
+	size_t taskCount() const noexcept
+	{
+		return m_tasks.size();
+	}
+
+	/// @brief タスクの名前を返します。
+	/// @param taskIndex タスクのインデックス（追加した順）
+	[[nodiscard]]
+	StringView taskName(size_t taskIndex) const noexcept
+	{
+		return m_tasks[taskIndex].name;
+	}
+
+	/// @brief 直前の run() での、タスクごとの処理時間（ナノ秒）を返します。
+	/// @remark 要素を分けて並列に処理したタスクでは、それぞれの処理時間の合計（すべてのスレッドでの処理時間の合計）です。
+	[[nodiscard]]
+	const Array<uint64>& taskNanosec() const noexcept
+	{
+		return m_taskNanosec;
+	}
+
+	/// @brief タスクの名前を、段ごとに返します。
+	[[nodiscard]]
+	Array<Array<StringView>> stages() const
+	{
+		Array<Array<StringView>> result(m_stageCount);
+
+		for (const auto& task : m_tasks)
+		{
+			result[task.stage] << task.name;
+		}
+
+		return result;
+	}
+
+private:
+
+	struct Task
+	{
+		StringView name;
+
+		ResourceMask reads;
+
+		ResourceMask writes;
+
+		TaskFunction function;
+
+		ItemCountFunction itemCount;
+
+		size_t grainSize;
+
+		// 依存の深さ
+		size_t stage;
+	};
+
+	struct WorkItem
+	{
+		TaskFunction function;
+
+		size_t taskIndex;
+
+		size_t begin;
+
+		size_t end;
+
+		// 処理時間（ナノ秒）
+		uint64 nanosec = 0;
+
+		void run(Context& context)
+		{
+			const uint64 start = Time::GetNanosec();
+			function(context, begin, end);
+			nanosec = (Time::GetNanosec() - start);
+		}
+	};
+
+	Array<Task> m_tasks;
+
+	size_t m_stageCount = 0;
+
+	// 実行中の段の処理（使い回す）
+	Array<WorkItem> m_workItems;
+
+	// 直前の run() での、タスクごとの処理時間（ナノ秒）
+	Array<uint64> m_taskNanosec;
+};